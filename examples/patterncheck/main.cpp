@@ -0,0 +1,321 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <tclap/cmdline.h>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/pugixml_helpers.hpp>
+#include <hadesmem/detail/region_alloc_size.hpp>
+#include <hadesmem/detail/str_conv.hpp>
+#include <hadesmem/detail/to_upper_ordinal.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/find_pattern.hpp>
+#include <hadesmem/process.hpp>
+
+// Validates and benchmarks a FindPattern XML file against PE files on disk.
+// Each file is checked against the patterns for the module it is an image of
+// (by name, unless --module is given). Every pattern is reported along with
+// its match count in the raw section data of the file and the anchor chosen
+// by FindPattern's batch matcher, and patterns which do not match exactly
+// once are flagged. The time taken to scan the file for all of its patterns
+// at once, as FindPattern does, is also reported. Start addresses and
+// manipulators are ignored, as they only make sense against a loaded module.
+
+namespace
+{
+struct PatternEntry
+{
+  std::wstring module;
+  std::wstring name;
+  std::wstring data;
+  bool scan_data;
+};
+
+bool HasScanDataFlag(pugi::xml_node const& node)
+{
+  for (auto const& flag : node.children(L"Flag"))
+  {
+    if (hadesmem::detail::pugixml::GetAttributeValue(flag, L"Name") ==
+        L"ScanData")
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+std::vector<PatternEntry> ReadPatternFile(std::wstring const& path,
+                                          std::wstring const* module_filter)
+{
+  pugi::xml_document doc;
+  auto const load_result = doc.load_file(path.c_str());
+  if (!load_result)
+  {
+    HADESMEM_DETAIL_THROW_EXCEPTION(
+      hadesmem::Error{}
+      << hadesmem::ErrorString{"Loading XML file failed."}
+      << hadesmem::ErrorCodeOther{static_cast<DWORD_PTR>(load_result.status)}
+      << hadesmem::ErrorStringOther{load_result.description()});
+  }
+
+  auto const hadesmem_root = doc.child(L"HadesMem");
+  if (!hadesmem_root)
+  {
+    HADESMEM_DETAIL_THROW_EXCEPTION(
+      hadesmem::Error{}
+      << hadesmem::ErrorString{"Failed to find 'HadesMem' root node."});
+  }
+
+  std::vector<PatternEntry> patterns;
+  for (auto const& find_pattern_node : hadesmem_root.children(L"FindPattern"))
+  {
+    auto const module_name = hadesmem::detail::ToUpperOrdinal(
+      hadesmem::detail::pugixml::GetOptionalAttributeValue(find_pattern_node,
+                                                           L"Module"));
+    if (module_filter &&
+        module_name != hadesmem::detail::ToUpperOrdinal(*module_filter))
+    {
+      continue;
+    }
+
+    bool const module_scan_data = HasScanDataFlag(find_pattern_node);
+    for (auto const& pattern : find_pattern_node.children(L"Pattern"))
+    {
+      patterns.emplace_back(PatternEntry{
+        module_name,
+        hadesmem::detail::pugixml::GetAttributeValue(pattern, L"Name"),
+        hadesmem::detail::pugixml::GetAttributeValue(pattern, L"Data"),
+        module_scan_data || HasScanDataFlag(pattern)});
+    }
+  }
+
+  return patterns;
+}
+
+// Module names may omit the '.dll' extension, as with GetModuleHandle.
+bool IsModuleFile(std::wstring const& module, std::wstring const& file_name)
+{
+  return module == file_name || module + L".DLL" == file_name;
+}
+
+// Selects the patterns for the module the file is an image of, based on its
+// name. Patterns for the main module (with no module name) are used for files
+// which aren't named after any other module.
+std::vector<PatternEntry>
+  GetFilePatterns(std::wstring const& path,
+                  std::vector<PatternEntry> const& patterns)
+{
+  auto const sep = path.find_last_of(L"\\/");
+  auto const file_name = hadesmem::detail::ToUpperOrdinal(
+    sep == std::wstring::npos ? path : path.substr(sep + 1));
+
+  std::vector<PatternEntry> file_patterns;
+  for (auto const& p : patterns)
+  {
+    if (!p.module.empty() && IsModuleFile(p.module, file_name))
+    {
+      file_patterns.push_back(p);
+    }
+  }
+
+  if (file_patterns.empty())
+  {
+    for (auto const& p : patterns)
+    {
+      if (p.module.empty())
+      {
+        file_patterns.push_back(p);
+      }
+    }
+  }
+
+  return file_patterns;
+}
+
+// Returns false if any pattern did not match exactly once.
+bool CheckFile(hadesmem::Process const& process,
+               std::wstring const& path,
+               std::vector<PatternEntry> const& patterns)
+{
+  std::wcout << "\nFile: " << path << "\n";
+
+  if (patterns.empty())
+  {
+    std::wcout << "  No patterns for this file.\n";
+    return true;
+  }
+
+  hadesmem::detail::MappedFileView const file_view{path};
+  auto const base = static_cast<std::uint8_t*>(file_view.GetBase());
+  auto const size = hadesmem::detail::GetRegionAllocSize(process, base);
+  auto const code_regions =
+    hadesmem::detail::GetPeFileScanRegions(process, base, size, false);
+  auto const data_regions =
+    hadesmem::detail::GetPeFileScanRegions(process, base, size, true);
+
+  std::vector<hadesmem::CompiledPattern> compiled;
+  hadesmem::detail::MultiPatternMatcher anchors;
+  for (auto const& p : patterns)
+  {
+    compiled.emplace_back(p.data);
+    auto const& data = compiled.back().GetData();
+    anchors.Add(data.data(), data.data() + data.size());
+  }
+
+  bool all_unique = true;
+  for (std::size_t i = 0; i < patterns.size(); ++i)
+  {
+    auto const& p = patterns[i];
+    auto const& regions = p.scan_data ? data_regions : code_regions;
+    std::size_t const count =
+      hadesmem::detail::CountMatchesLocal(regions, compiled[i]);
+
+    // The anchor used by FindPattern's batch matcher.
+    std::wcout << "  [" << p.module << "] " << p.name << ": " << std::dec
+               << count << " match(es), anchor ";
+    std::size_t const anchor_size = anchors.GetAnchorSize(i);
+    if (anchor_size)
+    {
+      std::size_t const anchor_offset = anchors.GetAnchorOffset(i);
+      std::wcout << "+" << anchor_offset << " (" << std::hex
+                 << std::setfill(L'0');
+      for (std::size_t j = 0; j < anchor_size; ++j)
+      {
+        std::wcout << (j ? " " : "") << "0x" << std::setw(2)
+                   << static_cast<std::uint32_t>(
+                        compiled[i].GetData()[anchor_offset + j].data);
+      }
+      std::wcout << std::dec << std::setfill(L' ') << ")\n";
+    }
+    else
+    {
+      std::wcout << "none\n";
+    }
+
+    if (count != 1)
+    {
+      std::wcout << (count ? "    WARNING! Pattern is not unique.\n"
+                           : "    WARNING! Pattern did not match.\n");
+      all_unique = false;
+    }
+  }
+
+  // Time the scan the way FindPattern does it, with every region searched
+  // once for all of the patterns interested in it.
+  std::size_t total_bytes = 0;
+  double total_seconds = 0.0;
+  for (int scan_data = 0; scan_data < 2; ++scan_data)
+  {
+    auto const& regions = scan_data ? data_regions : code_regions;
+    auto const start = std::chrono::high_resolution_clock::now();
+    bool scanned = false;
+    for (auto const& region : regions)
+    {
+      hadesmem::detail::MultiPatternMatcher matcher;
+      for (std::size_t i = 0; i < patterns.size(); ++i)
+      {
+        if (patterns[i].scan_data == !!scan_data)
+        {
+          auto const& data = compiled[i].GetData();
+          matcher.Add(data.data(), data.data() + data.size());
+        }
+      }
+
+      if (matcher.GetSize())
+      {
+        matcher.Search(region.first, region.second);
+        total_bytes += static_cast<std::size_t>(region.second - region.first);
+        scanned = true;
+      }
+    }
+    auto const end = std::chrono::high_resolution_clock::now();
+
+    if (scanned)
+    {
+      total_seconds +=
+        std::chrono::duration_cast<std::chrono::duration<double>>(end - start)
+          .count();
+    }
+  }
+
+  std::wcout << "FindPattern scan: " << total_bytes << " bytes in "
+             << std::fixed << std::setprecision(3) << total_seconds * 1000.0
+             << " ms";
+  if (total_seconds > 0.0)
+  {
+    std::wcout << " (" << (total_bytes / total_seconds) / (1024.0 * 1024.0)
+               << " MB/s)";
+  }
+  std::wcout << ".\n";
+
+  return all_unique;
+}
+}
+
+int main(int argc, char* argv[])
+{
+  try
+  {
+    std::cout << "HadesMem Pattern Checker [" << HADESMEM_VERSION_STRING
+              << "]\n";
+
+    TCLAP::CmdLine cmd{
+      "FindPattern file validator and benchmark", ' ', HADESMEM_VERSION_STRING};
+    TCLAP::ValueArg<std::string> patterns_arg{
+      "", "patterns", "FindPattern XML file", true, "", "string", cmd};
+    TCLAP::MultiArg<std::string> path_arg{
+      "", "path", "PE file to scan", true, "string", cmd};
+    TCLAP::ValueArg<std::string> module_arg{
+      "",
+      "module",
+      "Only check patterns for this module (default is all modules)",
+      false,
+      "",
+      "string",
+      cmd};
+    cmd.parse(argc, argv);
+
+    auto const module_filter =
+      hadesmem::detail::MultiByteToWideChar(module_arg.getValue());
+    auto const patterns = ReadPatternFile(
+      hadesmem::detail::MultiByteToWideChar(patterns_arg.getValue()),
+      module_arg.isSet() ? &module_filter : nullptr);
+    std::wcout << "\nLoaded " << patterns.size() << " pattern(s).\n";
+
+    hadesmem::Process const process{::GetCurrentProcessId()};
+    bool all_unique = true;
+    for (auto const& path : path_arg.getValue())
+    {
+      auto const path_wide = hadesmem::detail::MultiByteToWideChar(path);
+      // With a module filter every file is assumed to be that module.
+      auto const file_patterns = module_arg.isSet()
+                                   ? patterns
+                                   : GetFilePatterns(path_wide, patterns);
+      if (!CheckFile(process, path_wide, file_patterns))
+      {
+        all_unique = false;
+      }
+    }
+
+    return all_unique ? 0 : 2;
+  }
+  catch (...)
+  {
+    std::cerr << "\nError!\n"
+              << boost::current_exception_diagnostic_information() << '\n';
+
+    return 1;
+  }
+}
@@ -0,0 +1,153 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <windows.h>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/memory_backend.hpp>
+
+namespace hadesmem
+{
+// Presents a flat local buffer (e.g. a file read into memory or a mapped view
+// of one) as a single committed region at the given base address, so memory
+// dumps can be analyzed with the normal read/write/PE APIs. Everything below
+// the base is reported as free, and the address space ends at the end of the
+// buffer. Protection changes are recorded (and reported by Query) but not
+// enforced.
+class BufferMemoryBackend : public MemoryBackend
+{
+public:
+  // Does not take ownership of data, which must outlive the backend.
+  explicit BufferMemoryBackend(PVOID base, PVOID data, std::size_t size)
+    : base_{reinterpret_cast<std::uintptr_t>(base)},
+      data_{static_cast<std::uint8_t*>(data)},
+      size_{size},
+      protect_{PAGE_READWRITE}
+  {
+    HADESMEM_DETAIL_ASSERT(size_ ? data_ != nullptr : true);
+    HADESMEM_DETAIL_ASSERT(
+      size_ <= (std::numeric_limits<std::uintptr_t>::max)() - base_);
+  }
+
+  explicit BufferMemoryBackend(PVOID base, std::vector<std::uint8_t>&& data)
+    : base_{reinterpret_cast<std::uintptr_t>(base)},
+      owned_(std::move(data)),
+      data_{owned_.data()},
+      size_{owned_.size()},
+      protect_{PAGE_READWRITE}
+  {
+    HADESMEM_DETAIL_ASSERT(
+      size_ <= (std::numeric_limits<std::uintptr_t>::max)() - base_);
+  }
+
+  virtual bool Read(LPCVOID address, LPVOID data, std::size_t len) override
+  {
+    std::uint8_t* const src = Translate(address, len);
+    if (!src)
+    {
+      ::SetLastError(ERROR_PARTIAL_COPY);
+      return false;
+    }
+
+    std::memcpy(data, src, len);
+    return true;
+  }
+
+  virtual bool Write(LPVOID address, LPCVOID data, std::size_t len) override
+  {
+    std::uint8_t* const dst = Translate(address, len);
+    if (!dst)
+    {
+      ::SetLastError(ERROR_PARTIAL_COPY);
+      return false;
+    }
+
+    std::memcpy(dst, data, len);
+    return true;
+  }
+
+  virtual bool Query(LPCVOID address, MEMORY_BASIC_INFORMATION& mbi) override
+  {
+    auto const address_raw = reinterpret_cast<std::uintptr_t>(address);
+    mbi = MEMORY_BASIC_INFORMATION{};
+    if (address_raw < base_)
+    {
+      mbi.RegionSize = base_;
+      mbi.State = MEM_FREE;
+      mbi.Protect = PAGE_NOACCESS;
+      return true;
+    }
+
+    if (address_raw - base_ >= size_)
+    {
+      ::SetLastError(ERROR_INVALID_PARAMETER);
+      return false;
+    }
+
+    mbi.BaseAddress = reinterpret_cast<PVOID>(base_);
+    mbi.AllocationBase = reinterpret_cast<PVOID>(base_);
+    mbi.AllocationProtect = PAGE_READWRITE;
+    mbi.RegionSize = size_;
+    mbi.State = MEM_COMMIT;
+    mbi.Protect = protect_;
+    mbi.Type = MEM_PRIVATE;
+    return true;
+  }
+
+  virtual bool Protect(LPVOID address,
+                       SIZE_T size,
+                       DWORD protect,
+                       DWORD& old_protect) override
+  {
+    if (!Translate(address, size))
+    {
+      ::SetLastError(ERROR_INVALID_ADDRESS);
+      return false;
+    }
+
+    old_protect = protect_;
+    protect_ = protect;
+    return true;
+  }
+
+  PVOID GetBase() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return reinterpret_cast<PVOID>(base_);
+  }
+
+  std::size_t GetSize() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return size_;
+  }
+
+private:
+  std::uint8_t* Translate(LPCVOID address, std::size_t len) const
+    HADESMEM_DETAIL_NOEXCEPT
+  {
+    auto const address_raw = reinterpret_cast<std::uintptr_t>(address);
+    if (address_raw < base_ || address_raw - base_ > size_ ||
+        len > size_ - (address_raw - base_))
+    {
+      return nullptr;
+    }
+
+    return data_ + (address_raw - base_);
+  }
+
+  std::uintptr_t base_;
+  std::vector<std::uint8_t> owned_;
+  std::uint8_t* data_;
+  std::size_t size_;
+  DWORD protect_;
+};
+}
@@ -32,6 +32,7 @@
 #include <hadesmem/find_procedure.hpp>
 #include <hadesmem/flush.hpp>
 #include <hadesmem/module.hpp>
+#include <hadesmem/procedure_resolver.hpp>
 #include <hadesmem/process.hpp>
 #include <hadesmem/read.hpp>
 #include <hadesmem/write.hpp>
@@ -801,14 +802,15 @@ inline Allocator GenerateCallCode(Process const& process,
   HADESMEM_DETAIL_TRACE_A("GenerateCallCode called.");
 
   Module const kernel32{process, L"kernel32.dll"};
+  ProcedureResolver resolver{process};
   auto const get_last_error = reinterpret_cast<DWORD_PTR>(
-    FindProcedure(process, kernel32, "GetLastError"));
+    FindProcedure(resolver, kernel32, "GetLastError"));
   auto const set_last_error = reinterpret_cast<DWORD_PTR>(
-    FindProcedure(process, kernel32, "SetLastError"));
+    FindProcedure(resolver, kernel32, "SetLastError"));
   auto const is_debugger_present = reinterpret_cast<DWORD_PTR>(
-    FindProcedure(process, kernel32, "IsDebuggerPresent"));
-  auto const debug_break =
-    reinterpret_cast<DWORD_PTR>(FindProcedure(process, kernel32, "DebugBreak"));
+    FindProcedure(resolver, kernel32, "IsDebuggerPresent"));
+  auto const debug_break = reinterpret_cast<DWORD_PTR>(
+    FindProcedure(resolver, kernel32, "DebugBreak"));
 
   asmjit::JitRuntime runtime;
   asmjit::X86Assembler assembler{ &runtime };
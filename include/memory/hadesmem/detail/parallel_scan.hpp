@@ -0,0 +1,142 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <hadesmem/detail/assert.hpp>
+
+namespace hadesmem
+{
+namespace detail
+{
+inline std::size_t GetParallelScanThreadCount()
+{
+  unsigned int const num_threads = std::thread::hardware_concurrency();
+  return num_threads ? num_threads : 1;
+}
+
+// Splits [0, size) into chunks of chunk_size bytes and calls scan(offset,
+// length) for each of them on up to num_threads threads (including the
+// calling thread). Each chunk is extended by overlap bytes (pattern length
+// minus one) so that matches straddling a chunk boundary are still found.
+// scan must return the offset of the first match in its chunk, or size if
+// there is none. Returns the lowest match offset, or size if there is none,
+// so the result is identical to scanning [0, size) sequentially.
+template <typename ScanFunc>
+std::size_t ParallelScan(std::size_t size,
+                         std::size_t chunk_size,
+                         std::size_t overlap,
+                         std::size_t num_threads,
+                         ScanFunc scan)
+{
+  HADESMEM_DETAIL_ASSERT(chunk_size != 0);
+
+  std::size_t const num_chunks = size / chunk_size + !!(size % chunk_size);
+  if (!num_chunks)
+  {
+    return size;
+  }
+
+  num_threads = (std::max)(static_cast<std::size_t>(1),
+                           (std::min)(num_threads, num_chunks));
+
+  // Chunks are handed out in ascending order and a chunk is only skipped if
+  // a lower chunk has already matched, so once all workers are done every
+  // chunk below found_chunk has been scanned and results[found_chunk] is
+  // the lowest match.
+  std::atomic<std::size_t> next_chunk(0);
+  std::atomic<std::size_t> found_chunk(num_chunks);
+  std::atomic<bool> failed(false);
+  std::vector<std::size_t> results(num_chunks, size);
+  std::mutex error_mutex;
+  std::exception_ptr error;
+
+  auto const set_error = [&](std::exception_ptr e)
+  {
+    std::lock_guard<std::mutex> lock(error_mutex);
+    if (!error)
+    {
+      error = e;
+    }
+    failed = true;
+  };
+
+  auto const worker = [&]()
+  {
+    for (;;)
+    {
+      std::size_t const chunk = next_chunk++;
+      if (chunk >= num_chunks || chunk > found_chunk || failed)
+      {
+        return;
+      }
+
+      std::size_t const offset = chunk * chunk_size;
+      std::size_t const length =
+        (std::min)(chunk_size + overlap, size - offset);
+
+      try
+      {
+        std::size_t const match = scan(offset, length);
+        if (match == size)
+        {
+          continue;
+        }
+
+        HADESMEM_DETAIL_ASSERT(match >= offset && match < offset + length);
+        results[chunk] = match;
+
+        std::size_t current = found_chunk;
+        while (chunk < current &&
+               !found_chunk.compare_exchange_weak(current, chunk))
+        {
+        }
+      }
+      catch (...)
+      {
+        set_error(std::current_exception());
+        return;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  try
+  {
+    for (std::size_t i = 1; i < num_threads; ++i)
+    {
+      threads.emplace_back(worker);
+    }
+  }
+  catch (...)
+  {
+    // Carry on with however many threads we did manage to create (the
+    // calling thread alone is enough to scan every chunk).
+  }
+
+  worker();
+
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
+
+  std::size_t const found = found_chunk;
+  return found < num_chunks ? results[found] : size;
+}
+}
+}
@@ -0,0 +1,272 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/filesystem.hpp>
+#include <hadesmem/error.hpp>
+
+namespace hadesmem
+{
+namespace detail
+{
+std::uint64_t const kFnv1a64OffsetBasis = 0xCBF29CE484222325ULL;
+
+inline std::uint64_t HashFnv1a64(void const* data,
+                                 std::size_t len,
+                                 std::uint64_t hash = kFnv1a64OffsetBasis)
+{
+  auto const bytes = static_cast<std::uint8_t const*>(data);
+  for (std::size_t i = 0; i < len; ++i)
+  {
+    hash ^= bytes[i];
+    hash *= 0x100000001B3ULL;
+  }
+
+  return hash;
+}
+
+// Persistent cache of resolved pattern results. Entries are grouped by module
+// and tagged with the identity of the module image they were resolved
+// against (timestamp, checksum and image size from the NT headers), so
+// entries for a module which has since changed are never returned and are
+// discarded as soon as a new result for that module is inserted.
+class PatternCache
+{
+public:
+  struct ModuleId
+  {
+    DWORD time_date_stamp;
+    DWORD check_sum;
+    DWORD size_of_image;
+  };
+
+  struct Entry
+  {
+    // RVA of the match, before any manipulators are applied (they may read
+    // memory outside the module, so their results can't be cached).
+    std::uint64_t value;
+    bool matched;
+  };
+
+  Entry const* Lookup(std::wstring const& module,
+                      ModuleId const& id,
+                      std::uint64_t key) const
+  {
+    auto const module_iter = modules_.find(module);
+    if (module_iter == std::end(modules_) ||
+        !IsSameModule(module_iter->second.id, id))
+    {
+      return nullptr;
+    }
+
+    auto const& entries = module_iter->second.entries;
+    auto const entry_iter = entries.find(key);
+    return entry_iter != std::end(entries) ? &entry_iter->second : nullptr;
+  }
+
+  void Insert(std::wstring const& module,
+              ModuleId const& id,
+              std::uint64_t key,
+              Entry const& entry)
+  {
+    auto& module_entries = modules_[module];
+    if (!IsSameModule(module_entries.id, id))
+    {
+      module_entries.id = id;
+      module_entries.entries.clear();
+    }
+
+    module_entries.entries[key] = entry;
+    dirty_ = true;
+  }
+
+  bool IsDirty() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return dirty_;
+  }
+
+  std::vector<char> Serialize() const
+  {
+    std::vector<char> buffer;
+    WriteValue(buffer, static_cast<std::uint32_t>(kMagic));
+    WriteValue(buffer, static_cast<std::uint32_t>(kVersion));
+    WriteValue(buffer, static_cast<std::uint32_t>(modules_.size()));
+    for (auto const& module : modules_)
+    {
+      auto const& name = module.first;
+      WriteValue(buffer, static_cast<std::uint32_t>(name.size()));
+      for (auto const c : name)
+      {
+        WriteValue(buffer, static_cast<std::uint16_t>(c));
+      }
+
+      WriteValue(buffer, module.second.id.time_date_stamp);
+      WriteValue(buffer, module.second.id.check_sum);
+      WriteValue(buffer, module.second.id.size_of_image);
+      WriteValue(buffer,
+                 static_cast<std::uint32_t>(module.second.entries.size()));
+      for (auto const& entry : module.second.entries)
+      {
+        WriteValue(buffer, entry.first);
+        WriteValue(buffer, entry.second.value);
+        WriteValue(buffer, static_cast<std::uint8_t>(entry.second.matched));
+      }
+    }
+
+    return buffer;
+  }
+
+  // Returns false (and leaves the cache empty) if the buffer is not a cache
+  // written by a compatible version, so a corrupt cache file only costs a
+  // rescan.
+  bool Deserialize(std::vector<char> const& buffer)
+  {
+    modules_.clear();
+    dirty_ = false;
+
+    std::size_t pos = 0;
+    std::uint32_t magic = 0;
+    std::uint32_t version = 0;
+    std::uint32_t num_modules = 0;
+    if (!ReadValue(buffer, pos, magic) || magic != kMagic ||
+        !ReadValue(buffer, pos, version) || version != kVersion ||
+        !ReadValue(buffer, pos, num_modules))
+    {
+      return false;
+    }
+
+    for (std::uint32_t i = 0; i < num_modules; ++i)
+    {
+      std::uint32_t name_len = 0;
+      if (!ReadValue(buffer, pos, name_len) ||
+          name_len > (buffer.size() - pos) / sizeof(std::uint16_t))
+      {
+        modules_.clear();
+        return false;
+      }
+
+      std::wstring name(name_len, L'\0');
+      for (auto& c : name)
+      {
+        std::uint16_t c_raw = 0;
+        ReadValue(buffer, pos, c_raw);
+        c = static_cast<wchar_t>(c_raw);
+      }
+
+      ModuleEntries module_entries;
+      std::uint32_t num_entries = 0;
+      if (!ReadValue(buffer, pos, module_entries.id.time_date_stamp) ||
+          !ReadValue(buffer, pos, module_entries.id.check_sum) ||
+          !ReadValue(buffer, pos, module_entries.id.size_of_image) ||
+          !ReadValue(buffer, pos, num_entries))
+      {
+        modules_.clear();
+        return false;
+      }
+
+      for (std::uint32_t j = 0; j < num_entries; ++j)
+      {
+        std::uint64_t key = 0;
+        Entry entry{};
+        std::uint8_t matched = 0;
+        if (!ReadValue(buffer, pos, key) ||
+            !ReadValue(buffer, pos, entry.value) ||
+            !ReadValue(buffer, pos, matched))
+        {
+          modules_.clear();
+          return false;
+        }
+
+        entry.matched = !!matched;
+        module_entries.entries[key] = entry;
+      }
+
+      modules_[name] = module_entries;
+    }
+
+    return true;
+  }
+
+  // A missing or unreadable cache file is treated as an empty cache.
+  void LoadFile(std::wstring const& path)
+  {
+    modules_.clear();
+    dirty_ = false;
+
+    if (!DoesFileExist(path))
+    {
+      return;
+    }
+
+    try
+    {
+      Deserialize(FileToBuffer(path));
+    }
+    catch (hadesmem::Error const&)
+    {
+      modules_.clear();
+    }
+  }
+
+  void SaveFile(std::wstring const& path)
+  {
+    auto const buffer = Serialize();
+    BufferToFile(
+      path, buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    dirty_ = false;
+  }
+
+private:
+  static std::uint32_t const kMagic = 0x43504D48; // 'HMPC'
+  static std::uint32_t const kVersion = 3;
+
+  struct ModuleEntries
+  {
+    ModuleId id;
+    std::map<std::uint64_t, Entry> entries;
+  };
+
+  static bool IsSameModule(ModuleId const& lhs, ModuleId const& rhs)
+    HADESMEM_DETAIL_NOEXCEPT
+  {
+    return lhs.time_date_stamp == rhs.time_date_stamp &&
+           lhs.check_sum == rhs.check_sum &&
+           lhs.size_of_image == rhs.size_of_image;
+  }
+
+  template <typename T>
+  static void WriteValue(std::vector<char>& buffer, T const& value)
+  {
+    auto const bytes = reinterpret_cast<char const*>(&value);
+    buffer.insert(std::end(buffer), bytes, bytes + sizeof(value));
+  }
+
+  template <typename T>
+  static bool
+    ReadValue(std::vector<char> const& buffer, std::size_t& pos, T& value)
+  {
+    if (buffer.size() - pos < sizeof(value))
+    {
+      return false;
+    }
+
+    std::memcpy(&value, buffer.data() + pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+  }
+
+  std::map<std::wstring, ModuleEntries> modules_;
+  bool dirty_{};
+};
+}
+}
@@ -0,0 +1,660 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <hadesmem/detail/assert.hpp>
+
+// WARNING: This header must not depend on the Windows API (directly or
+// indirectly) so that the matching code can be built and benchmarked against
+// plain in-memory buffers on any platform.
+
+// Define HADESMEM_NO_PATTERN_SIMD to force the scalar search kernel.
+#if !defined(HADESMEM_NO_PATTERN_SIMD)
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64) ||              \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HADESMEM_DETAIL_PATTERN_SSE2
+#endif
+#if defined(__AVX2__)
+#define HADESMEM_DETAIL_PATTERN_AVX2
+#endif
+#endif // #if !defined(HADESMEM_NO_PATTERN_SIMD)
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(HADESMEM_DETAIL_PATTERN_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(HADESMEM_DETAIL_PATTERN_AVX2)
+#include <immintrin.h>
+#endif
+
+namespace hadesmem
+{
+namespace detail
+{
+struct PatternDataByte
+{
+  std::uint8_t data;
+  bool wildcard;
+};
+
+inline bool MatchPatternAt(std::uint8_t const* h,
+                           PatternDataByte const* n_beg,
+                           PatternDataByte const* n_end)
+{
+  for (; n_beg != n_end; ++n_beg, ++h)
+  {
+    if (!n_beg->wildcard && *h != n_beg->data)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+inline std::uint32_t CountTrailingZeros(std::uint32_t value)
+{
+  HADESMEM_DETAIL_ASSERT(value != 0);
+
+#if defined(_MSC_VER)
+  unsigned long index = 0;
+  _BitScanForward(&index, value);
+  return static_cast<std::uint32_t>(index);
+#else
+  return static_cast<std::uint32_t>(__builtin_ctz(value));
+#endif
+}
+
+// Rough ranking of how common a byte is in x86/x64 code and data. Higher is
+// more common, zero means 'rare'. Used to pick anchor bytes that produce as
+// few false candidates as possible.
+inline std::uint32_t GetByteCommonness(std::uint8_t b)
+{
+  static std::uint8_t const kCommonBytes[] = {
+    0x00, 0xFF, 0x48, 0x8B, 0xCC, 0x89, 0x24, 0x0F, 0x44, 0x4C, 0xE8,
+    0x85, 0x01, 0x83, 0x8D, 0x74, 0x90, 0x45, 0x08, 0x10, 0x40, 0xC0,
+    0x75, 0x20, 0x04, 0xC3, 0x4D, 0x49, 0x41, 0x33, 0xEB, 0x84};
+  std::size_t const num_common = sizeof(kCommonBytes);
+  for (std::size_t i = 0; i < num_common; ++i)
+  {
+    if (kCommonBytes[i] == b)
+    {
+      return static_cast<std::uint32_t>(num_common - i);
+    }
+  }
+
+  return 0;
+}
+
+// Finds the first match of a single wildcard pattern. Candidates are located
+// by comparing the two rarest non-wildcard bytes of the pattern against 16
+// (SSE2) or 32 (AVX2) haystack positions at a time, and are then verified
+// against a packed value/mask representation of the pattern 8 bytes at a time.
+// Without SIMD, long patterns whose anchor byte is common are searched using
+// a Horspool skip table (wildcards bound the maximum skip) instead. All kernels
+// return identical results.
+class PatternSearcher
+{
+public:
+  template <typename NeedleIterator>
+  explicit PatternSearcher(NeedleIterator n_beg, NeedleIterator n_end)
+  {
+    for (; n_beg != n_end; ++n_beg)
+    {
+      PatternDataByte const& cur = *n_beg;
+      value_.push_back(cur.wildcard ? 0 : cur.data);
+      mask_.push_back(cur.wildcard ? 0 : 0xFF);
+    }
+
+    Initialize();
+  }
+
+  std::size_t GetSize() const
+  {
+    return value_.size();
+  }
+
+  std::size_t GetAnchorOffset() const
+  {
+    return anchors_[0];
+  }
+
+  bool HasAnchor() const
+  {
+    return has_anchor_;
+  }
+
+  bool Matches(std::uint8_t const* h) const
+  {
+    std::size_t const num_packed = value_packed_.size();
+    for (std::size_t i = 0; i < num_packed; ++i)
+    {
+      std::uint64_t cur;
+      std::memcpy(&cur, h + i * 8, sizeof(cur));
+      if ((cur & mask_packed_[i]) != value_packed_[i])
+      {
+        return false;
+      }
+    }
+
+    for (std::size_t i = num_packed * 8; i < value_.size(); ++i)
+    {
+      if ((h[i] & mask_[i]) != value_[i])
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // Returns a pointer to the first match, or nullptr.
+  std::uint8_t const* Search(std::uint8_t const* h_beg,
+                             std::uint8_t const* h_end) const
+  {
+#if defined(HADESMEM_DETAIL_PATTERN_AVX2)
+    return SearchAvx2(h_beg, h_end);
+#elif defined(HADESMEM_DETAIL_PATTERN_SSE2)
+    return SearchSse2(h_beg, h_end);
+#else
+    return SearchScalar(h_beg, h_end);
+#endif
+  }
+
+  std::uint8_t const* SearchScalar(std::uint8_t const* h_beg,
+                                   std::uint8_t const* h_end) const
+  {
+    return use_horspool_ ? SearchHorspool(h_beg, h_end)
+                         : SearchScalarFrom(h_beg, h_end, 0);
+  }
+
+  std::uint8_t const* SearchHorspool(std::uint8_t const* h_beg,
+                                     std::uint8_t const* h_end) const
+  {
+    HADESMEM_DETAIL_ASSERT(h_beg <= h_end);
+
+    std::size_t const h_len = static_cast<std::size_t>(h_end - h_beg);
+    std::size_t const n_len = value_.size();
+    if (n_len > h_len)
+    {
+      return nullptr;
+    }
+
+    std::size_t const num_pos = h_len - n_len + 1;
+    for (std::size_t pos = 0; pos < num_pos;)
+    {
+      if (Matches(h_beg + pos))
+      {
+        return h_beg + pos;
+      }
+
+      pos += skip_[h_beg[pos + n_len - 1]];
+    }
+
+    return nullptr;
+  }
+
+#if defined(HADESMEM_DETAIL_PATTERN_SSE2)
+  std::uint8_t const* SearchSse2(std::uint8_t const* h_beg,
+                                 std::uint8_t const* h_end) const
+  {
+    HADESMEM_DETAIL_ASSERT(h_beg <= h_end);
+
+    std::size_t const h_len = static_cast<std::size_t>(h_end - h_beg);
+    if (!has_anchor_ || value_.size() > h_len)
+    {
+      return SearchScalar(h_beg, h_end);
+    }
+
+    // Number of valid match positions.
+    std::size_t const num_pos = h_len - value_.size() + 1;
+    __m128i const anchor_0 =
+      _mm_set1_epi8(static_cast<char>(value_[anchors_[0]]));
+    __m128i const anchor_1 =
+      _mm_set1_epi8(static_cast<char>(value_[anchors_[1]]));
+    std::size_t pos = 0;
+    for (; pos + 16 <= num_pos; pos += 16)
+    {
+      __m128i const block_0 = _mm_loadu_si128(
+        reinterpret_cast<__m128i const*>(h_beg + pos + anchors_[0]));
+      __m128i const block_1 = _mm_loadu_si128(
+        reinterpret_cast<__m128i const*>(h_beg + pos + anchors_[1]));
+      __m128i const eq = _mm_and_si128(_mm_cmpeq_epi8(block_0, anchor_0),
+                                       _mm_cmpeq_epi8(block_1, anchor_1));
+      std::uint32_t candidates =
+        static_cast<std::uint32_t>(_mm_movemask_epi8(eq));
+      while (candidates)
+      {
+        std::uint8_t const* const cur =
+          h_beg + pos + CountTrailingZeros(candidates);
+        if (Matches(cur))
+        {
+          return cur;
+        }
+
+        candidates &= candidates - 1;
+      }
+    }
+
+    return SearchScalarFrom(h_beg, h_end, pos);
+  }
+#endif // #if defined(HADESMEM_DETAIL_PATTERN_SSE2)
+
+#if defined(HADESMEM_DETAIL_PATTERN_AVX2)
+  std::uint8_t const* SearchAvx2(std::uint8_t const* h_beg,
+                                 std::uint8_t const* h_end) const
+  {
+    HADESMEM_DETAIL_ASSERT(h_beg <= h_end);
+
+    std::size_t const h_len = static_cast<std::size_t>(h_end - h_beg);
+    if (!has_anchor_ || value_.size() > h_len)
+    {
+      return SearchScalar(h_beg, h_end);
+    }
+
+    std::size_t const num_pos = h_len - value_.size() + 1;
+    __m256i const anchor_0 =
+      _mm256_set1_epi8(static_cast<char>(value_[anchors_[0]]));
+    __m256i const anchor_1 =
+      _mm256_set1_epi8(static_cast<char>(value_[anchors_[1]]));
+    std::size_t pos = 0;
+    for (; pos + 32 <= num_pos; pos += 32)
+    {
+      __m256i const block_0 = _mm256_loadu_si256(
+        reinterpret_cast<__m256i const*>(h_beg + pos + anchors_[0]));
+      __m256i const block_1 = _mm256_loadu_si256(
+        reinterpret_cast<__m256i const*>(h_beg + pos + anchors_[1]));
+      __m256i const eq =
+        _mm256_and_si256(_mm256_cmpeq_epi8(block_0, anchor_0),
+                         _mm256_cmpeq_epi8(block_1, anchor_1));
+      std::uint32_t candidates =
+        static_cast<std::uint32_t>(_mm256_movemask_epi8(eq));
+      while (candidates)
+      {
+        std::uint8_t const* const cur =
+          h_beg + pos + CountTrailingZeros(candidates);
+        if (Matches(cur))
+        {
+          return cur;
+        }
+
+        candidates &= candidates - 1;
+      }
+    }
+
+    return SearchScalarFrom(h_beg, h_end, pos);
+  }
+#endif // #if defined(HADESMEM_DETAIL_PATTERN_AVX2)
+
+private:
+  static std::size_t const kMinHorspoolSkip = 8;
+
+  void Initialize()
+  {
+    HADESMEM_DETAIL_ASSERT(!value_.empty());
+
+    anchors_[0] = anchors_[1] = 0;
+    skip_.assign(0x100, 1);
+
+    std::size_t const num_packed = value_.size() / 8;
+    for (std::size_t i = 0; i < num_packed; ++i)
+    {
+      std::uint64_t value = 0;
+      std::uint64_t mask = 0;
+      std::memcpy(&value, &value_[i * 8], sizeof(value));
+      std::memcpy(&mask, &mask_[i * 8], sizeof(mask));
+      value_packed_.push_back(value);
+      mask_packed_.push_back(mask);
+    }
+
+    // Pick the two rarest non-wildcard bytes as anchors (preferring the
+    // earliest on ties). With a single non-wildcard byte both anchors are the
+    // same byte.
+    std::vector<std::size_t> offsets;
+    for (std::size_t i = 0; i < value_.size(); ++i)
+    {
+      if (mask_[i])
+      {
+        offsets.push_back(i);
+      }
+    }
+
+    if (offsets.empty())
+    {
+      return;
+    }
+
+    std::stable_sort(std::begin(offsets),
+                     std::end(offsets),
+                     [this](std::size_t lhs, std::size_t rhs)
+                     {
+      return GetByteCommonness(value_[lhs]) < GetByteCommonness(value_[rhs]);
+    });
+
+    has_anchor_ = true;
+    anchors_[0] = offsets[0];
+    anchors_[1] = offsets.size() > 1 ? offsets[1] : offsets[0];
+
+    // Horspool shifts are based on the haystack byte under the last pattern
+    // position. A wildcard at index i (other than the last) matches anything,
+    // so no shift may be larger than n - 1 - i.
+    std::size_t const n_len = value_.size();
+    std::size_t max_skip = n_len;
+    for (std::size_t i = 0; i + 1 < n_len; ++i)
+    {
+      if (!mask_[i])
+      {
+        max_skip = n_len - 1 - i;
+      }
+    }
+
+    skip_.assign(0x100, max_skip);
+    for (std::size_t i = 0; i + 1 < n_len; ++i)
+    {
+      if (mask_[i])
+      {
+        skip_[value_[i]] = (std::min)(max_skip, n_len - 1 - i);
+      }
+    }
+
+    use_horspool_ =
+      max_skip >= kMinHorspoolSkip &&
+      GetByteCommonness(value_[anchors_[0]]) != 0;
+  }
+
+  std::uint8_t const* SearchScalarFrom(std::uint8_t const* h_beg,
+                                       std::uint8_t const* h_end,
+                                       std::size_t pos) const
+  {
+    HADESMEM_DETAIL_ASSERT(h_beg <= h_end);
+
+    std::size_t const h_len = static_cast<std::size_t>(h_end - h_beg);
+    if (value_.size() > h_len)
+    {
+      return nullptr;
+    }
+
+    std::size_t const num_pos = h_len - value_.size() + 1;
+    if (!has_anchor_)
+    {
+      return pos < num_pos ? h_beg + pos : nullptr;
+    }
+
+    std::uint8_t const anchor_0 = value_[anchors_[0]];
+    std::uint8_t const anchor_1 = value_[anchors_[1]];
+    while (pos < num_pos)
+    {
+      // Jump straight to the next occurrence of the rarest byte.
+      void const* const next = std::memchr(
+        h_beg + pos + anchors_[0], anchor_0, num_pos - pos);
+      if (!next)
+      {
+        return nullptr;
+      }
+
+      pos = static_cast<std::size_t>(static_cast<std::uint8_t const*>(next) -
+                                     h_beg) - anchors_[0];
+      if (h_beg[pos + anchors_[1]] == anchor_1 && Matches(h_beg + pos))
+      {
+        return h_beg + pos;
+      }
+
+      ++pos;
+    }
+
+    return nullptr;
+  }
+
+  std::vector<std::uint8_t> value_;
+  std::vector<std::uint8_t> mask_;
+  std::vector<std::uint64_t> value_packed_;
+  std::vector<std::uint64_t> mask_packed_;
+  std::vector<std::size_t> skip_;
+  bool has_anchor_{false};
+  bool use_horspool_{false};
+  std::size_t anchors_[2];
+};
+
+// Matches an arbitrary number of wildcard patterns against a buffer in a
+// single pass. Every pattern is keyed on an 'anchor' (the rarest pair of
+// adjacent non-wildcard bytes if available, otherwise a single byte),
+// candidates are found via a bitmap filter on the anchor and then verified in
+// full. The first (lowest) match of each pattern at or after its minimum
+// offset is reported. Pattern data is referenced, not copied, so it must
+// outlive the matcher.
+class MultiPatternMatcher
+{
+public:
+  static std::size_t const kNoMatch = static_cast<std::size_t>(-1);
+
+  std::size_t Add(PatternDataByte const* n_beg,
+                  PatternDataByte const* n_end,
+                  std::size_t min_offset = 0)
+  {
+    HADESMEM_DETAIL_ASSERT(n_beg < n_end);
+
+    std::size_t const id = needles_.size();
+    Needle needle{n_beg, n_end, min_offset, 0U, 0U, AnchorType::kNone};
+
+    // Prefer the rarest pair of adjacent non-wildcard bytes, falling back to
+    // the rarest single byte.
+    std::uint32_t best_pair = static_cast<std::uint32_t>(-1);
+    std::uint32_t best_single = static_cast<std::uint32_t>(-1);
+    std::size_t const len = static_cast<std::size_t>(n_end - n_beg);
+    for (std::size_t i = 0; i < len; ++i)
+    {
+      if (n_beg[i].wildcard)
+      {
+        continue;
+      }
+
+      std::uint32_t const cur_single = GetByteCommonness(n_beg[i].data);
+      if (i + 1 < len && !n_beg[i + 1].wildcard)
+      {
+        std::uint32_t const cur_pair =
+          cur_single + GetByteCommonness(n_beg[i + 1].data);
+        if (cur_pair < best_pair)
+        {
+          best_pair = cur_pair;
+          needle.anchor_offset = i;
+          needle.anchor_key = static_cast<std::uint16_t>(
+            n_beg[i].data | (n_beg[i + 1].data << 8));
+          needle.anchor_type = AnchorType::kPair;
+        }
+      }
+      else if (needle.anchor_type != AnchorType::kPair &&
+               cur_single < best_single)
+      {
+        best_single = cur_single;
+        needle.anchor_offset = i;
+        needle.anchor_key = n_beg[i].data;
+        needle.anchor_type = AnchorType::kSingle;
+      }
+    }
+
+    needles_.push_back(needle);
+
+    return id;
+  }
+
+  std::size_t GetSize() const
+  {
+    return needles_.size();
+  }
+
+  // Offset of the anchor within the pattern.
+  std::size_t GetAnchorOffset(std::size_t id) const
+  {
+    HADESMEM_DETAIL_ASSERT(id < needles_.size());
+    return needles_[id].anchor_offset;
+  }
+
+  // Number of bytes in the anchor (2 for a pair, 1 for a single byte, or 0
+  // if the pattern is all wildcards).
+  std::size_t GetAnchorSize(std::size_t id) const
+  {
+    HADESMEM_DETAIL_ASSERT(id < needles_.size());
+    switch (needles_[id].anchor_type)
+    {
+    case AnchorType::kPair:
+      return 2;
+    case AnchorType::kSingle:
+      return 1;
+    default:
+      return 0;
+    }
+  }
+
+  // Returns the offset (relative to h_beg) of the first match for each pattern
+  // in the order they were added, or kNoMatch.
+  std::vector<std::size_t> Search(std::uint8_t const* h_beg,
+                                  std::uint8_t const* h_end) const
+  {
+    HADESMEM_DETAIL_ASSERT(h_beg <= h_end);
+
+    std::size_t const h_len = static_cast<std::size_t>(h_end - h_beg);
+    std::vector<std::size_t> results(needles_.size(),
+                                     static_cast<std::size_t>(kNoMatch));
+    std::size_t remaining = 0;
+
+    std::vector<std::uint32_t> pair_filter(0x10000 / 32);
+    std::vector<std::uint32_t> single_filter(0x100 / 32);
+    std::vector<std::pair<std::uint16_t, std::size_t>> pair_index;
+    std::vector<std::pair<std::uint16_t, std::size_t>> single_index;
+
+    // Lowest haystack position at which any anchor could still contribute
+    // to a match.
+    std::size_t scan_beg = h_len;
+
+    for (std::size_t i = 0; i < needles_.size(); ++i)
+    {
+      Needle const& n = needles_[i];
+      std::size_t const n_len = static_cast<std::size_t>(n.end - n.beg);
+      if (n.min_offset > h_len || n_len > h_len - n.min_offset)
+      {
+        continue;
+      }
+
+      // Patterns made up of nothing but wildcards trivially match at their
+      // first valid position.
+      if (n.anchor_type == AnchorType::kNone)
+      {
+        results[i] = n.min_offset;
+        continue;
+      }
+
+      auto& filter =
+        n.anchor_type == AnchorType::kPair ? pair_filter : single_filter;
+      auto& index =
+        n.anchor_type == AnchorType::kPair ? pair_index : single_index;
+      filter[n.anchor_key / 32] |= 1U << (n.anchor_key % 32);
+      index.emplace_back(n.anchor_key, i);
+
+      scan_beg = (std::min)(scan_beg, n.min_offset + n.anchor_offset);
+      ++remaining;
+    }
+
+    std::sort(std::begin(pair_index), std::end(pair_index));
+    std::sort(std::begin(single_index), std::end(single_index));
+
+    bool const have_pairs = !pair_index.empty();
+    bool const have_singles = !single_index.empty();
+
+    for (std::size_t pos = scan_beg; remaining && pos < h_len; ++pos)
+    {
+      std::uint8_t const cur = h_beg[pos];
+
+      if (have_singles && (single_filter[cur / 32] & (1U << (cur % 32))))
+      {
+        remaining -= Verify(h_beg, h_len, pos, cur, single_index, results);
+      }
+
+      if (have_pairs && pos + 1 < h_len)
+      {
+        std::uint16_t const key =
+          static_cast<std::uint16_t>(cur | (h_beg[pos + 1] << 8));
+        if (pair_filter[key / 32] & (1U << (key % 32)))
+        {
+          remaining -= Verify(h_beg, h_len, pos, key, pair_index, results);
+        }
+      }
+    }
+
+    return results;
+  }
+
+private:
+  enum class AnchorType
+  {
+    kNone,
+    kSingle,
+    kPair
+  };
+
+  struct Needle
+  {
+    PatternDataByte const* beg;
+    PatternDataByte const* end;
+    std::size_t min_offset;
+    std::size_t anchor_offset;
+    std::uint16_t anchor_key;
+    AnchorType anchor_type;
+  };
+
+  std::size_t
+    Verify(std::uint8_t const* h_beg,
+           std::size_t h_len,
+           std::size_t pos,
+           std::uint16_t key,
+           std::vector<std::pair<std::uint16_t, std::size_t>> const& index,
+           std::vector<std::size_t>& results) const
+  {
+    std::size_t num_matched = 0;
+
+    auto const first = std::make_pair(key, static_cast<std::size_t>(0));
+    auto iter = std::lower_bound(std::begin(index), std::end(index), first);
+    for (; iter != std::end(index) && iter->first == key; ++iter)
+    {
+      std::size_t const id = iter->second;
+      if (results[id] != kNoMatch)
+      {
+        continue;
+      }
+
+      Needle const& n = needles_[id];
+      if (pos < n.anchor_offset)
+      {
+        continue;
+      }
+
+      std::size_t const n_len = static_cast<std::size_t>(n.end - n.beg);
+      std::size_t const match_beg = pos - n.anchor_offset;
+      if (match_beg < n.min_offset || n_len > h_len - match_beg)
+      {
+        continue;
+      }
+
+      if (MatchPatternAt(h_beg + match_beg, n.beg, n.end))
+      {
+        results[id] = match_beg;
+        ++num_matched;
+      }
+    }
+
+    return num_matched;
+  }
+
+  std::vector<Needle> needles_;
+};
+}
+}
@@ -33,7 +33,7 @@ public:
   explicit ProtectGuard(Process const& process,
                         PVOID address,
                         ProtectGuardType type)
-    : ProtectGuard{process, Query(process, address), type}
+    : ProtectGuard{process, QueryCached(process, address), type}
   {
   }
 
@@ -46,16 +46,18 @@ public:
       old_protect_{0},
       mbi_(mbi)
   {
-    if (IsBadProtect(mbi_))
+    CheckProtect();
+
+    // The region may have come from the region cache. That's fine for
+    // deciding that nothing needs to change, but the protection actually
+    // changed (and later restored) must be current.
+    if (!can_read_or_write_ && process.GetRegionCache())
     {
-      HADESMEM_DETAIL_THROW_EXCEPTION(
-        Error{} << ErrorString{
-          "Attempt to access page with a 'bad' protection mask."});
+      InvalidateRegionCache(process, mbi_.BaseAddress, mbi_.RegionSize);
+      mbi_ = QueryCached(process, mbi_.BaseAddress);
+      CheckProtect();
     }
 
-    can_read_or_write_ =
-      (type_ == ProtectGuardType::kRead) ? CanRead(mbi_) : CanWrite(mbi_);
-
     if (!can_read_or_write_)
     {
       try
@@ -142,6 +144,19 @@ public:
   }
 
 private:
+  void CheckProtect()
+  {
+    if (IsBadProtect(mbi_))
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{
+          "Attempt to access page with a 'bad' protection mask."});
+    }
+
+    can_read_or_write_ =
+      (type_ == ProtectGuardType::kRead) ? CanRead(mbi_) : CanWrite(mbi_);
+  }
+
   Process const* process_;
   ProtectGuardType type_;
   bool can_read_or_write_;
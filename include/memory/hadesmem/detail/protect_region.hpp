@@ -7,6 +7,7 @@
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
+#include <hadesmem/memory_backend.hpp>
 #include <hadesmem/process.hpp>
 
 namespace hadesmem
@@ -18,6 +19,20 @@ inline DWORD Protect(Process const& process,
                      DWORD protect)
 {
   DWORD old_protect = 0;
+  if (MemoryBackend* const backend = process.GetMemoryBackend())
+  {
+    if (!backend->Protect(
+          mbi.BaseAddress, mbi.RegionSize, protect, old_protect))
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"MemoryBackend::Protect failed."}
+                << ErrorCodeWinLast{last_error});
+    }
+
+    return old_protect;
+  }
+
   if (!::VirtualProtectEx(process.GetHandle(),
                           mbi.BaseAddress,
                           mbi.RegionSize,
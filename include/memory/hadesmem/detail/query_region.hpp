@@ -6,7 +6,9 @@
 #include <windows.h>
 
 #include <hadesmem/config.hpp>
+#include <hadesmem/detail/region_cache.hpp>
 #include <hadesmem/error.hpp>
+#include <hadesmem/memory_backend.hpp>
 #include <hadesmem/process.hpp>
 
 namespace hadesmem
@@ -16,6 +18,19 @@ namespace detail
 inline MEMORY_BASIC_INFORMATION Query(Process const& process, LPCVOID address)
 {
   MEMORY_BASIC_INFORMATION mbi{};
+  if (MemoryBackend* const backend = process.GetMemoryBackend())
+  {
+    if (!backend->Query(address, mbi))
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"MemoryBackend::Query failed."}
+                << ErrorCodeWinLast{last_error});
+    }
+
+    return mbi;
+  }
+
   if (::VirtualQueryEx(process.GetHandle(), address, &mbi, sizeof(mbi)) !=
       sizeof(mbi))
   {
@@ -28,6 +43,75 @@ inline MEMORY_BASIC_INFORMATION Query(Process const& process, LPCVOID address)
   return mbi;
 }
 
+// Same as Query, but consults the region cache of the process (if enabled)
+// first. from_cache is set if the result came from the cache, in which case
+// it may be stale.
+inline MEMORY_BASIC_INFORMATION QueryCached(Process const& process,
+                                            LPCVOID address,
+                                            bool* from_cache = nullptr)
+{
+  RegionCache* const cache = process.GetRegionCache();
+  MEMORY_BASIC_INFORMATION mbi{};
+  bool const hit = cache && cache->Lookup(address, mbi);
+  if (from_cache)
+  {
+    *from_cache = hit;
+  }
+
+  if (!hit)
+  {
+    mbi = Query(process, address);
+    if (cache)
+    {
+      cache->Insert(mbi);
+    }
+  }
+
+  return mbi;
+}
+
+inline void
+  InvalidateRegionCache(Process const& process, LPCVOID address, SIZE_T size)
+{
+  if (RegionCache* const cache = process.GetRegionCache())
+  {
+    cache->InvalidateRange(address, size);
+  }
+}
+
+// Calls func with the region containing address. If func fails on a region
+// which came from the cache then the entry is assumed to be stale, so it is
+// dropped and func is retried once with a fresh query. func must therefore
+// be safe to repeat.
+template <typename Func>
+void WithRegion(Process const& process, LPCVOID address, Func func)
+{
+  bool from_cache = false;
+  MEMORY_BASIC_INFORMATION const mbi =
+    QueryCached(process, address, &from_cache);
+  if (!from_cache)
+  {
+    func(mbi);
+    return;
+  }
+
+  bool failed = false;
+  try
+  {
+    func(mbi);
+  }
+  catch (...)
+  {
+    failed = true;
+  }
+
+  if (failed)
+  {
+    InvalidateRegionCache(process, mbi.BaseAddress, mbi.RegionSize);
+    func(QueryCached(process, address));
+  }
+}
+
 inline bool
   CanRead(MEMORY_BASIC_INFORMATION const& mbi) HADESMEM_DETAIL_NOEXCEPT
 {
@@ -0,0 +1,113 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <hadesmem/detail/assert.hpp>
+
+namespace hadesmem
+{
+namespace detail
+{
+struct ReadBatchRange
+{
+  std::uintptr_t address;
+  std::size_t size;
+};
+
+// A single read covering the requests order[first, first + count).
+struct ReadBatchSpan
+{
+  std::uintptr_t address;
+  std::size_t size;
+  std::size_t first;
+  std::size_t count;
+};
+
+struct ReadBatchPlan
+{
+  // Indices of the (non-empty) requests sorted by address.
+  std::vector<std::size_t> order;
+  std::vector<ReadBatchSpan> spans;
+};
+
+// Sorts the requested ranges and merges those which overlap or are separated
+// by at most max_gap bytes into spans, as long as the merged span is no larger
+// than max_span_size (0 means no limit). A request is never split, so a span
+// containing a single request may be larger than max_span_size. Empty
+// requests are not part of any span.
+inline ReadBatchPlan PlanReadBatch(std::vector<ReadBatchRange> const& ranges,
+                                   std::size_t max_gap,
+                                   std::size_t max_span_size)
+{
+  std::uintptr_t const max_address =
+    (std::numeric_limits<std::uintptr_t>::max)();
+  auto const get_end = [&](ReadBatchRange const& range)
+  {
+    return range.size > max_address - range.address
+             ? max_address
+             : range.address + range.size;
+  };
+
+  ReadBatchPlan plan;
+  plan.order.reserve(ranges.size());
+  for (std::size_t i = 0; i < ranges.size(); ++i)
+  {
+    if (ranges[i].size)
+    {
+      plan.order.push_back(i);
+    }
+  }
+
+  std::stable_sort(std::begin(plan.order),
+                   std::end(plan.order),
+                   [&](std::size_t lhs, std::size_t rhs)
+                   {
+    return ranges[lhs].address < ranges[rhs].address;
+  });
+
+  std::uintptr_t span_end = 0;
+  for (std::size_t i = 0; i < plan.order.size(); ++i)
+  {
+    ReadBatchRange const& range = ranges[plan.order[i]];
+    std::uintptr_t const range_end = get_end(range);
+
+    if (!plan.spans.empty())
+    {
+      ReadBatchSpan& span = plan.spans.back();
+      HADESMEM_DETAIL_ASSERT(range.address >= span.address);
+
+      bool const is_close = range.address <= span_end ||
+                            range.address - span_end <= max_gap;
+      std::uintptr_t const new_end = (std::max)(span_end, range_end);
+      bool const is_small =
+        !max_span_size ||
+        new_end - span.address <= static_cast<std::uintptr_t>(max_span_size);
+      if (is_close && is_small)
+      {
+        span_end = new_end;
+        span.size = static_cast<std::size_t>(span_end - span.address);
+        ++span.count;
+        continue;
+      }
+    }
+
+    ReadBatchSpan const span = {
+      range.address,
+      static_cast<std::size_t>(range_end - range.address),
+      i,
+      1};
+    plan.spans.push_back(span);
+    span_end = range_end;
+  }
+
+  return plan;
+}
+}
+}
@@ -9,13 +9,16 @@
 
 #include <windows.h>
 
+#include <hadesmem/config.hpp>
 #include <hadesmem/detail/assert.hpp>
 #include <hadesmem/detail/protect_guard.hpp>
 #include <hadesmem/detail/query_region.hpp>
 #include <hadesmem/detail/type_traits.hpp>
 #include <hadesmem/error.hpp>
+#include <hadesmem/memory_backend.hpp>
 #include <hadesmem/process.hpp>
 #include <hadesmem/protect.hpp>
+#include <hadesmem/remote_memory_cache.hpp>
 
 namespace hadesmem
 {
@@ -23,8 +26,12 @@ struct ReadFlags
 {
   enum : std::uint32_t
   {
-    kNone,
-    kZeroFillReserved
+    kNone = 0,
+    kZeroFillReserved = 1 << 0,
+    // Try a plain ReadProcessMemory first, without querying or changing
+    // protection. The normal path is only used if that fails.
+    kAssumeAccessible = 1 << 1,
+    kInvalidFlagMaxValue = 1 << 2
   };
 };
 
@@ -44,6 +51,19 @@ inline void ReadUnchecked(Process const& process,
     return;
   }
 
+  if (MemoryBackend* const backend = process.GetMemoryBackend())
+  {
+    if (!backend->Read(address, data, len))
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"MemoryBackend::Read failed."}
+                << ErrorCodeWinLast{last_error});
+    }
+
+    return;
+  }
+
   SIZE_T bytes_read = 0;
   if (!::ReadProcessMemory(
         process.GetHandle(), address, data, len, &bytes_read) ||
@@ -56,11 +76,27 @@ inline void ReadUnchecked(Process const& process,
   }
 }
 
-inline void ReadImpl(Process const& process,
-                     void* address,
-                     void* data,
-                     std::size_t len,
-                     std::uint32_t flags = ReadFlags::kNone)
+inline bool TryReadUnchecked(Process const& process,
+                             void* address,
+                             void* data,
+                             std::size_t len) HADESMEM_DETAIL_NOEXCEPT
+{
+  if (MemoryBackend* const backend = process.GetMemoryBackend())
+  {
+    return backend->Read(address, data, len);
+  }
+
+  SIZE_T bytes_read = 0;
+  return ::ReadProcessMemory(
+           process.GetHandle(), address, data, len, &bytes_read) &&
+         bytes_read == len;
+}
+
+inline void ReadUncachedImpl(Process const& process,
+                             void* address,
+                             void* data,
+                             std::size_t len,
+                             std::uint32_t flags = ReadFlags::kNone)
 {
   HADESMEM_DETAIL_ASSERT(len ? address != nullptr : true);
   HADESMEM_DETAIL_ASSERT(data != nullptr);
@@ -70,58 +106,155 @@ inline void ReadImpl(Process const& process,
     return;
   }
 
-  for (;;)
+  MemoryBackend* const backend = process.GetMemoryBackend();
+  bool const try_direct = !!(flags & ReadFlags::kAssumeAccessible) ||
+                          (backend && backend->IsDirect());
+  if (try_direct && TryReadUnchecked(process, address, data, len))
   {
-    MEMORY_BASIC_INFORMATION const mbi = detail::Query(process, address);
+    return;
+  }
 
-    void* const address_end = static_cast<std::uint8_t*>(address) + len;
+  std::size_t len_new = 0;
+  auto const read_region = [&](MEMORY_BASIC_INFORMATION const& mbi)
+  {
     void* const region_next =
       static_cast<std::uint8_t*>(mbi.BaseAddress) + mbi.RegionSize;
+    len_new = (std::min)(len,
+                         static_cast<std::size_t>(
+                           reinterpret_cast<std::uintptr_t>(region_next) -
+                           reinterpret_cast<std::uintptr_t>(address)));
 
-    bool const should_zero_fill =
-      (mbi.State == MEM_RESERVE && !!(flags & ReadFlags::kZeroFillReserved));
-
-    if (address_end <= region_next)
+    if (mbi.State == MEM_RESERVE && !!(flags & ReadFlags::kZeroFillReserved))
     {
-      if (should_zero_fill)
-      {
-        std::fill(static_cast<std::uint8_t*>(data),
-                  static_cast<std::uint8_t*>(data) + len,
-                  0);
-      }
-      else
-      {
-        ProtectGuard protect_guard{process, mbi, ProtectGuardType::kRead};
-        ReadUnchecked(process, address, data, len, flags);
-        protect_guard.Restore();
-      }
+      std::fill(static_cast<std::uint8_t*>(data),
+                static_cast<std::uint8_t*>(data) + len_new,
+                0);
+    }
+    else
+    {
+      ProtectGuard protect_guard{process, mbi, ProtectGuardType::kRead};
+      ReadUnchecked(process, address, data, len_new, flags);
+      protect_guard.Restore();
+    }
+  };
 
+  for (;;)
+  {
+    WithRegion(process, address, read_region);
+
+    if (len_new == len)
+    {
       return;
     }
-    else
+
+    address = static_cast<std::uint8_t*>(address) + len_new;
+    data = static_cast<std::uint8_t*>(data) + len_new;
+    len -= len_new;
+  }
+}
+
+// Sets *used_fallback (if given) if any run of pages had to be fetched
+// through the normal path because a plain read of it failed.
+inline bool ReadCachedImpl(Process const& process,
+                           RemoteMemoryCache& cache,
+                           void* address,
+                           void* data,
+                           std::size_t len,
+                           bool* used_fallback = nullptr)
+{
+  auto const fetch =
+    [&](std::uintptr_t base, std::uint8_t* run_data, std::size_t run_len)
+      -> bool
+  {
+    auto const run_address = reinterpret_cast<void*>(base);
+    if (TryReadUnchecked(process, run_address, run_data, run_len))
     {
-      std::size_t const len_new =
-        reinterpret_cast<std::uintptr_t>(region_next) -
-        reinterpret_cast<std::uintptr_t>(address);
+      return true;
+    }
 
-      if (should_zero_fill)
-      {
-        std::fill(static_cast<std::uint8_t*>(data),
-                  static_cast<std::uint8_t*>(data) + len_new,
-                  0);
-      }
-      else
+    try
+    {
+      ReadUncachedImpl(process, run_address, run_data, run_len);
+      if (used_fallback)
       {
-        ProtectGuard protect_guard{process, mbi, ProtectGuardType::kRead};
-        ReadUnchecked(process, address, data, len_new, flags);
-        protect_guard.Restore();
+        *used_fallback = true;
       }
 
-      address = static_cast<std::uint8_t*>(address) + len_new;
-      data = static_cast<std::uint8_t*>(data) + len_new;
-      len -= len_new;
+      return true;
+    }
+    catch (Error const&)
+    {
+      return false;
     }
+  };
+
+  return cache.Read(
+    reinterpret_cast<std::uintptr_t>(address), data, len, fetch);
+}
+
+// Reads through the memory cache of the process if it has one. Reads which
+// can't be served from the cache (because a page involved is unreadable or
+// the read is too large to cache) go through the normal path so they fail
+// (or are zero filled) as usual.
+inline void ReadImpl(Process const& process,
+                     void* address,
+                     void* data,
+                     std::size_t len,
+                     std::uint32_t flags = ReadFlags::kNone)
+{
+  HADESMEM_DETAIL_ASSERT(len ? address != nullptr : true);
+  HADESMEM_DETAIL_ASSERT(data != nullptr);
+
+  if (!len)
+  {
+    return;
   }
+
+  RemoteMemoryCache* const cache = process.GetMemoryCache();
+  if (cache && ReadCachedImpl(process, *cache, address, data, len))
+  {
+    return;
+  }
+
+  ReadUncachedImpl(process, address, data, len, flags);
+}
+
+// Same as ReadImpl with ReadFlags::kAssumeAccessible, but returns false if
+// the fast path failed and the normal path had to be used instead.
+inline bool ReadFastImpl(Process const& process,
+                         void* address,
+                         void* data,
+                         std::size_t len,
+                         std::uint32_t flags = ReadFlags::kNone)
+{
+  HADESMEM_DETAIL_ASSERT(len ? address != nullptr : true);
+  HADESMEM_DETAIL_ASSERT(data != nullptr);
+
+  if (!len)
+  {
+    return true;
+  }
+
+  RemoteMemoryCache* const cache = process.GetMemoryCache();
+  bool used_fallback = false;
+  if (cache &&
+      ReadCachedImpl(process, *cache, address, data, len, &used_fallback))
+  {
+    return !used_fallback;
+  }
+
+  if (TryReadUnchecked(process, address, data, len))
+  {
+    return true;
+  }
+
+  ReadUncachedImpl(
+    process,
+    address,
+    data,
+    len,
+    flags & ~static_cast<std::uint32_t>(ReadFlags::kAssumeAccessible));
+  return false;
 }
 
 template <typename T>
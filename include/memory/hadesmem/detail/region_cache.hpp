@@ -0,0 +1,127 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <mutex>
+
+#include <windows.h>
+
+#include <hadesmem/config.hpp>
+
+namespace hadesmem
+{
+namespace detail
+{
+// Cache of region information for a process, keyed by region base address.
+// Entries never overlap, so the region containing an address (if cached) is
+// the last entry whose base is not above it.
+// Invalidate bumps an epoch counter rather than clearing the map directly, so
+// it is cheap, lock-free and safe to call from anywhere. Entries from an older
+// epoch are discarded on the next access.
+class RegionCache
+{
+public:
+  bool Lookup(void const* address, MEMORY_BASIC_INFORMATION& mbi)
+  {
+    auto const address_raw = reinterpret_cast<std::uintptr_t>(address);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    SyncEpoch();
+
+    auto iter = regions_.upper_bound(address_raw);
+    if (iter == std::begin(regions_))
+    {
+      return false;
+    }
+
+    --iter;
+    if (address_raw - iter->first >= iter->second.RegionSize)
+    {
+      return false;
+    }
+
+    mbi = iter->second;
+    return true;
+  }
+
+  void Insert(MEMORY_BASIC_INFORMATION const& mbi)
+  {
+    auto const base = reinterpret_cast<std::uintptr_t>(mbi.BaseAddress);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    SyncEpoch();
+    EraseRange(base, mbi.RegionSize);
+    regions_[base] = mbi;
+  }
+
+  void Invalidate() HADESMEM_DETAIL_NOEXCEPT
+  {
+    ++epoch_;
+  }
+
+  // Drops every entry overlapping [address, address + size).
+  void InvalidateRange(void const* address, std::size_t size)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SyncEpoch();
+    EraseRange(reinterpret_cast<std::uintptr_t>(address), size);
+  }
+
+  std::uint32_t GetEpoch() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return epoch_;
+  }
+
+  std::size_t GetSize()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SyncEpoch();
+    return regions_.size();
+  }
+
+private:
+  void SyncEpoch()
+  {
+    std::uint32_t const epoch = epoch_;
+    if (epoch != synced_epoch_)
+    {
+      regions_.clear();
+      synced_epoch_ = epoch;
+    }
+  }
+
+  void EraseRange(std::uintptr_t base, std::size_t size)
+  {
+    std::uintptr_t const max_address =
+      (std::numeric_limits<std::uintptr_t>::max)();
+    std::uintptr_t const end =
+      size > max_address - base ? max_address : base + size;
+
+    auto first = regions_.lower_bound(base);
+    if (first != std::begin(regions_))
+    {
+      auto const prev = std::prev(first);
+      if (base - prev->first < prev->second.RegionSize)
+      {
+        first = prev;
+      }
+    }
+
+    auto const last = regions_.lower_bound(end);
+    regions_.erase(first, last);
+  }
+
+  std::mutex mutex_;
+  std::map<std::uintptr_t, MEMORY_BASIC_INFORMATION> regions_;
+  std::atomic<std::uint32_t> epoch_{0};
+  std::uint32_t synced_epoch_{0};
+};
+}
+}
@@ -0,0 +1,237 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <hadesmem/detail/assert.hpp>
+
+// WARNING: This header must not depend on the Windows API (directly or
+// indirectly) so that the diff code can be built and benchmarked against
+// plain in-memory buffers on any platform.
+
+// Define HADESMEM_NO_SNAPSHOT_DIFF_SIMD to force the scalar compare.
+#if !defined(HADESMEM_NO_SNAPSHOT_DIFF_SIMD)
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64) ||              \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HADESMEM_DETAIL_SNAPSHOT_DIFF_SSE2
+#endif
+#endif // #if !defined(HADESMEM_NO_SNAPSHOT_DIFF_SIMD)
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(HADESMEM_DETAIL_SNAPSHOT_DIFF_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace hadesmem
+{
+namespace detail
+{
+inline std::uint32_t SnapshotCountTrailingZeros(std::uint32_t value)
+{
+  HADESMEM_DETAIL_ASSERT(value != 0);
+
+#if defined(_MSC_VER)
+  unsigned long index = 0;
+  _BitScanForward(&index, value);
+  return static_cast<std::uint32_t>(index);
+#else
+  return static_cast<std::uint32_t>(__builtin_ctz(value));
+#endif
+}
+
+// Returns the first position in [pos, len) at which the buffers differ if
+// find_different is set, or are equal otherwise. Returns len if there is
+// none.
+inline std::size_t FindSnapshotMismatch(std::uint8_t const* lhs,
+                                        std::uint8_t const* rhs,
+                                        std::size_t pos,
+                                        std::size_t len,
+                                        bool find_different)
+{
+#if defined(HADESMEM_DETAIL_SNAPSHOT_DIFF_SSE2)
+  std::uint32_t const flip = find_different ? 0xFFFFU : 0U;
+  for (; pos + 16 <= len; pos += 16)
+  {
+    __m128i const lhs_block =
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(lhs + pos));
+    __m128i const rhs_block =
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(rhs + pos));
+    // Bit set for each equal byte, then flipped so a set bit is a hit.
+    std::uint32_t const hits =
+      static_cast<std::uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(lhs_block, rhs_block))) ^
+      flip;
+    if (hits)
+    {
+      return pos + SnapshotCountTrailingZeros(hits);
+    }
+  }
+#endif // #if defined(HADESMEM_DETAIL_SNAPSHOT_DIFF_SSE2)
+
+  for (; pos < len; ++pos)
+  {
+    if ((lhs[pos] != rhs[pos]) == find_different)
+    {
+      return pos;
+    }
+  }
+
+  return len;
+}
+
+// Calls func(offset, size) for each run of bytes which differ between
+// old_data and new_data. Runs separated by fewer than merge_gap equal bytes
+// are reported as a single run. Returns the number of runs.
+template <typename Func>
+std::size_t DiffSnapshots(std::uint8_t const* old_data,
+                          std::uint8_t const* new_data,
+                          std::size_t len,
+                          std::size_t merge_gap,
+                          Func func)
+{
+  std::size_t num_runs = 0;
+  std::size_t pos = FindSnapshotMismatch(old_data, new_data, 0, len, true);
+  while (pos < len)
+  {
+    std::size_t const run_beg = pos;
+    std::size_t run_end = pos;
+    for (;;)
+    {
+      run_end = FindSnapshotMismatch(old_data, new_data, pos, len, false);
+      pos = FindSnapshotMismatch(old_data, new_data, run_end, len, true);
+      if (pos == len || pos - run_end >= merge_gap)
+      {
+        break;
+      }
+    }
+
+    func(run_beg, run_end - run_beg);
+    ++num_runs;
+  }
+
+  return num_runs;
+}
+
+// Keeps the previous and current contents of a set of ranges. Each poll the
+// caller fills the current buffers (marking those it couldn't read as
+// invalid), diffs them against the previous ones and then calls Advance.
+class SnapshotStore
+{
+public:
+  std::size_t AddRange(std::uintptr_t address, std::size_t size)
+  {
+    ranges_.emplace_back();
+    Range& range = ranges_.back();
+    range.address = address;
+    range.current.resize(size);
+    range.previous.resize(size);
+    return ranges_.size() - 1;
+  }
+
+  std::size_t GetNumRanges() const
+  {
+    return ranges_.size();
+  }
+
+  std::uintptr_t GetAddress(std::size_t index) const
+  {
+    HADESMEM_DETAIL_ASSERT(index < ranges_.size());
+    return ranges_[index].address;
+  }
+
+  std::size_t GetSize(std::size_t index) const
+  {
+    HADESMEM_DETAIL_ASSERT(index < ranges_.size());
+    return ranges_[index].current.size();
+  }
+
+  std::uint8_t* GetCurrent(std::size_t index)
+  {
+    HADESMEM_DETAIL_ASSERT(index < ranges_.size());
+    return ranges_[index].current.data();
+  }
+
+  std::uint8_t const* GetPrevious(std::size_t index) const
+  {
+    HADESMEM_DETAIL_ASSERT(index < ranges_.size());
+    return ranges_[index].previous.data();
+  }
+
+  void SetCurrentValid(std::size_t index, bool valid)
+  {
+    HADESMEM_DETAIL_ASSERT(index < ranges_.size());
+    ranges_[index].current_valid = valid;
+  }
+
+  // Calls func(address, old_data, new_data, size) for each changed run in
+  // ranges which are valid in both snapshots. Returns the number of runs.
+  template <typename Func> std::size_t Diff(std::size_t merge_gap, Func func)
+  {
+    std::size_t num_runs = 0;
+    for (auto const& range : ranges_)
+    {
+      if (!range.current_valid || !range.previous_valid)
+      {
+        continue;
+      }
+
+      std::uint8_t const* const old_data = range.previous.data();
+      std::uint8_t const* const new_data = range.current.data();
+      num_runs += DiffSnapshots(
+        old_data,
+        new_data,
+        range.current.size(),
+        merge_gap,
+        [&](std::size_t offset, std::size_t size)
+        {
+          func(range.address + offset,
+               old_data + offset,
+               new_data + offset,
+               size);
+        });
+    }
+
+    return num_runs;
+  }
+
+  // Makes the current snapshot the previous one.
+  void Advance()
+  {
+    for (auto& range : ranges_)
+    {
+      range.previous.swap(range.current);
+      range.previous_valid = range.current_valid;
+      range.current_valid = false;
+    }
+  }
+
+  void Clear()
+  {
+    ranges_.clear();
+  }
+
+private:
+  struct Range
+  {
+    Range() : address{0}, current_valid{false}, previous_valid{false}
+    {
+    }
+
+    std::uintptr_t address;
+    std::vector<std::uint8_t> current;
+    std::vector<std::uint8_t> previous;
+    bool current_valid;
+    bool previous_valid;
+  };
+
+  std::vector<Range> ranges_;
+};
+}
+}
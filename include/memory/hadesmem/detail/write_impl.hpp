@@ -3,17 +3,22 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 
 #include <windows.h>
 
+#include <hadesmem/config.hpp>
 #include <hadesmem/detail/assert.hpp>
 #include <hadesmem/detail/protect_guard.hpp>
 #include <hadesmem/detail/query_region.hpp>
 #include <hadesmem/detail/type_traits.hpp>
 #include <hadesmem/error.hpp>
+#include <hadesmem/memory_backend.hpp>
 #include <hadesmem/process.hpp>
 #include <hadesmem/protect.hpp>
+#include <hadesmem/remote_memory_cache.hpp>
 
 namespace hadesmem
 {
@@ -28,6 +33,19 @@ inline void WriteUnchecked(Process const& process,
   HADESMEM_DETAIL_ASSERT(data != nullptr);
   HADESMEM_DETAIL_ASSERT(len != 0);
 
+  if (MemoryBackend* const backend = process.GetMemoryBackend())
+  {
+    if (!backend->Write(address, data, len))
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"MemoryBackend::Write failed."}
+                << ErrorCodeWinLast{last_error});
+    }
+
+    return;
+  }
+
   SIZE_T bytes_written = 0;
   if (!::WriteProcessMemory(
         process.GetHandle(), address, data, len, &bytes_written) ||
@@ -40,6 +58,32 @@ inline void WriteUnchecked(Process const& process,
   }
 }
 
+inline bool TryWriteUnchecked(Process const& process,
+                              PVOID address,
+                              LPCVOID data,
+                              std::size_t len) HADESMEM_DETAIL_NOEXCEPT
+{
+  if (MemoryBackend* const backend = process.GetMemoryBackend())
+  {
+    return backend->Write(address, data, len);
+  }
+
+  SIZE_T bytes_written = 0;
+  return ::WriteProcessMemory(
+           process.GetHandle(), address, data, len, &bytes_written) &&
+         bytes_written == len;
+}
+
+inline void InvalidateMemoryCache(Process const& process,
+                                  PVOID address,
+                                  std::size_t len)
+{
+  if (RemoteMemoryCache* const cache = process.GetMemoryCache())
+  {
+    cache->InvalidateRange(reinterpret_cast<std::uintptr_t>(address), len);
+  }
+}
+
 inline void WriteImpl(Process const& process,
                       PVOID address,
                       LPCVOID data,
@@ -49,38 +93,66 @@ inline void WriteImpl(Process const& process,
   HADESMEM_DETAIL_ASSERT(data != nullptr);
   HADESMEM_DETAIL_ASSERT(len != 0);
 
-  for (;;)
+  InvalidateMemoryCache(process, address, len);
+
+  MemoryBackend* const backend = process.GetMemoryBackend();
+  if (backend && backend->IsDirect() &&
+      TryWriteUnchecked(process, address, data, len))
   {
-    ProtectGuard protect_guard{process, address, ProtectGuardType::kWrite};
+    return;
+  }
 
-    MEMORY_BASIC_INFORMATION const mbi = detail::Query(process, address);
+  std::size_t len_new = 0;
+  auto const write_region = [&](MEMORY_BASIC_INFORMATION const& mbi)
+  {
     void* const region_next =
       static_cast<std::uint8_t*>(mbi.BaseAddress) + mbi.RegionSize;
+    len_new = (std::min)(len,
+                         static_cast<std::size_t>(
+                           reinterpret_cast<std::uintptr_t>(region_next) -
+                           reinterpret_cast<std::uintptr_t>(address)));
 
-    void* const address_end = static_cast<std::uint8_t*>(address) + len;
-    if (address_end <= region_next)
-    {
-      WriteUnchecked(process, address, data, len);
+    ProtectGuard protect_guard{process, mbi, ProtectGuardType::kWrite};
+    WriteUnchecked(process, address, data, len_new);
+    protect_guard.Restore();
+  };
 
-      protect_guard.Restore();
+  for (;;)
+  {
+    WithRegion(process, address, write_region);
 
+    if (len_new == len)
+    {
       return;
     }
-    else
-    {
-      std::size_t const len_new =
-        reinterpret_cast<std::uintptr_t>(region_next) -
-        reinterpret_cast<std::uintptr_t>(address);
 
-      WriteUnchecked(process, address, data, len_new);
+    address = static_cast<std::uint8_t*>(address) + len_new;
+    data = static_cast<std::uint8_t const*>(data) + len_new;
+    len -= len_new;
+  }
+}
+
+// Writes straight to the target without querying or changing protection,
+// falling back to WriteImpl only if that fails. Returns false if the
+// fallback was used.
+inline bool WriteFastImpl(Process const& process,
+                          PVOID address,
+                          LPCVOID data,
+                          std::size_t len)
+{
+  HADESMEM_DETAIL_ASSERT(address != nullptr);
+  HADESMEM_DETAIL_ASSERT(data != nullptr);
+  HADESMEM_DETAIL_ASSERT(len != 0);
 
-      protect_guard.Restore();
+  InvalidateMemoryCache(process, address, len);
 
-      address = static_cast<std::uint8_t*>(address) + len_new;
-      data = static_cast<std::uint8_t const*>(data) + len_new;
-      len -= len_new;
-    }
+  if (TryWriteUnchecked(process, address, data, len))
+  {
+    return true;
   }
+
+  WriteImpl(process, address, data, len);
+  return false;
 }
 
 template <typename T>
@@ -0,0 +1,117 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <windows.h>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/read_impl.hpp>
+#include <hadesmem/detail/static_assert.hpp>
+#include <hadesmem/detail/type_traits.hpp>
+#include <hadesmem/detail/write_impl.hpp>
+#include <hadesmem/process.hpp>
+
+namespace hadesmem
+{
+// Reads and writes memory on the assumption that it is already accessible,
+// skipping the region query and protection changes done by Read/Write. If an
+// access fails it is retried through the normal (guarded) path, and the
+// number of times that happened is recorded so callers can tell whether the
+// assumption actually holds for their workload.
+class FastAccessor
+{
+public:
+  explicit FastAccessor(Process const& process) HADESMEM_DETAIL_NOEXCEPT
+    : process_{&process},
+      num_accesses_{0},
+      num_fallbacks_{0}
+  {
+  }
+
+  explicit FastAccessor(Process&& process) = delete;
+
+  template <typename T> T Read(PVOID address)
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+    HADESMEM_DETAIL_STATIC_ASSERT(std::is_default_constructible<T>::value);
+
+    HADESMEM_DETAIL_ASSERT(address != nullptr);
+
+    T data;
+    Read(address, std::addressof(data), sizeof(data));
+    return data;
+  }
+
+  template <typename T, typename Alloc = std::allocator<T>>
+  std::vector<T, Alloc> ReadVector(PVOID address, std::size_t count)
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+    HADESMEM_DETAIL_STATIC_ASSERT(std::is_default_constructible<T>::value);
+
+    HADESMEM_DETAIL_ASSERT(count ? address != nullptr : true);
+
+    std::vector<T, Alloc> data(count);
+    if (count)
+    {
+      Read(address, data.data(), sizeof(T) * count);
+    }
+    return data;
+  }
+
+  void Read(PVOID address, void* data, std::size_t len)
+  {
+    ++num_accesses_;
+    if (!detail::ReadFastImpl(*process_, address, data, len))
+    {
+      ++num_fallbacks_;
+    }
+  }
+
+  template <typename T> void Write(PVOID address, T const& data)
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+
+    HADESMEM_DETAIL_ASSERT(address != nullptr);
+
+    Write(address, std::addressof(data), sizeof(data));
+  }
+
+  void Write(PVOID address, LPCVOID data, std::size_t len)
+  {
+    ++num_accesses_;
+    if (!detail::WriteFastImpl(*process_, address, data, len))
+    {
+      ++num_fallbacks_;
+    }
+  }
+
+  std::uint64_t GetNumAccesses() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return num_accesses_;
+  }
+
+  std::uint64_t GetNumFallbacks() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return num_fallbacks_;
+  }
+
+  void ResetCounts() HADESMEM_DETAIL_NOEXCEPT
+  {
+    num_accesses_ = 0;
+    num_fallbacks_ = 0;
+  }
+
+private:
+  Process const* process_;
+  std::uint64_t num_accesses_;
+  std::uint64_t num_fallbacks_;
+};
+}
@@ -9,8 +9,11 @@
 #include <limits>
 #include <locale>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -23,6 +26,9 @@
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/parallel_scan.hpp>
+#include <hadesmem/detail/pattern_cache.hpp>
+#include <hadesmem/detail/pattern_matcher.hpp>
 #include <hadesmem/detail/pugixml_helpers.hpp>
 #include <hadesmem/detail/smart_handle.hpp>
 #include <hadesmem/detail/static_assert.hpp>
@@ -50,7 +56,8 @@ struct PatternFlags
     kThrowOnUnmatch = 1 << 0,
     kRelativeAddress = 1 << 1,
     kScanData = 1 << 2,
-    kInvalidFlagMaxValue = 1 << 3
+    kParallel = 1 << 3,
+    kInvalidFlagMaxValue = 1 << 4
   };
 };
 
@@ -134,12 +141,6 @@ inline void* Rel(Process const& process,
   }
 }
 
-struct PatternDataByte
-{
-  std::uint8_t data;
-  bool wildcard;
-};
-
 inline std::vector<PatternDataByte> ConvertData(std::wstring const& data)
 {
   HADESMEM_DETAIL_ASSERT(!data.empty());
@@ -186,35 +187,167 @@ inline std::vector<PatternDataByte> ConvertData(std::wstring const& data)
 
   return data_real;
 }
+}
+
+struct PatternByte
+{
+  enum : std::uint32_t
+  {
+    kWildcard = 0x100
+  };
+};
+
+namespace detail
+{
+template <std::uint32_t... Bytes> struct IsValidPatternBytes;
+
+template <> struct IsValidPatternBytes<> : std::true_type
+{
+};
+
+template <std::uint32_t Byte, std::uint32_t... Bytes>
+struct IsValidPatternBytes<Byte, Bytes...>
+  : std::integral_constant<bool,
+                           (Byte <= 0xFF || Byte == PatternByte::kWildcard) &&
+                             IsValidPatternBytes<Bytes...>::value>
+{
+};
+}
+
+// A typed pattern literal whose bytes are given as template arguments (with
+// PatternByte::kWildcard for wildcards). Its bytes are validated at compile
+// time and its data is a static array, so it is never parsed from a string.
+// Only the data is static: the anchor bytes and skip table are still computed
+// at runtime when it is converted to a CompiledPattern, so convert it once
+// and reuse the result for repeated scans.
+template <std::uint32_t... Bytes> class StaticPattern
+{
+public:
+  HADESMEM_DETAIL_STATIC_ASSERT(sizeof...(Bytes) != 0);
+  HADESMEM_DETAIL_STATIC_ASSERT(detail::IsValidPatternBytes<Bytes...>::value);
+
+  typedef detail::PatternDataByte const(&DataArray)[sizeof...(Bytes)];
+
+  static std::size_t GetSize()
+  {
+    return sizeof...(Bytes);
+  }
+
+  static DataArray GetData()
+  {
+    return kData;
+  }
+
+private:
+  static detail::PatternDataByte const kData[sizeof...(Bytes)];
+};
+
+template <std::uint32_t... Bytes>
+detail::PatternDataByte const StaticPattern<Bytes...>::kData[sizeof...(
+  Bytes)] = {detail::PatternDataByte{static_cast<std::uint8_t>(Bytes & 0xFF),
+                                     Bytes == PatternByte::kWildcard}...};
+
+// A parsed and preprocessed pattern (packed value/mask arrays, anchor bytes
+// and skip table), so that patterns which are scanned for repeatedly only pay
+// the parsing and preprocessing cost once.
+class CompiledPattern
+{
+public:
+  explicit CompiledPattern(std::wstring const& data)
+    : data_(detail::ConvertData(data)),
+      searcher_{std::begin(data_), std::end(data_)}
+  {
+  }
+
+  template <typename NeedleIterator>
+  explicit CompiledPattern(NeedleIterator n_beg, NeedleIterator n_end)
+    : data_(n_beg, n_end), searcher_{std::begin(data_), std::end(data_)}
+  {
+  }
+
+  template <std::uint32_t... Bytes>
+  CompiledPattern(StaticPattern<Bytes...> const& pattern)
+    : data_(std::begin(pattern.GetData()), std::end(pattern.GetData())),
+      searcher_{std::begin(data_), std::end(data_)}
+  {
+  }
+
+  std::size_t GetSize() const
+  {
+    return data_.size();
+  }
+
+  std::size_t GetAnchorOffset() const
+  {
+    return searcher_.GetAnchorOffset();
+  }
+
+  std::vector<detail::PatternDataByte> const& GetData() const
+  {
+    return data_;
+  }
+
+  detail::PatternSearcher const& GetSearcher() const
+  {
+    return searcher_;
+  }
+
+private:
+  std::vector<detail::PatternDataByte> data_;
+  detail::PatternSearcher searcher_;
+};
+
+namespace detail
+{
+std::size_t const kParallelScanChunkSize = 4 * 1024 * 1024;
 
-template <typename NeedleIterator>
-void* FindRaw(Process const& process,
-              std::uint8_t* s_beg,
-              std::uint8_t* s_end,
-              NeedleIterator n_beg,
-              NeedleIterator n_end)
+inline void* FindRawParallel(Process const& process,
+                             std::uint8_t* s_beg,
+                             std::uint8_t* s_end,
+                             CompiledPattern const& pattern)
+{
+  std::size_t const size = static_cast<std::size_t>(s_end - s_beg);
+  auto const& searcher = pattern.GetSearcher();
+  std::size_t const match = ParallelScan(
+    size,
+    kParallelScanChunkSize,
+    pattern.GetSize() - 1,
+    GetParallelScanThreadCount(),
+    [&](std::size_t offset, std::size_t length)
+    {
+      std::vector<std::uint8_t> const haystack{
+        ReadVector<std::uint8_t>(process, s_beg + offset, length)};
+      auto const h_beg = haystack.data();
+      auto const found = searcher.Search(h_beg, h_beg + haystack.size());
+      return found ? offset + static_cast<std::size_t>(found - h_beg) : size;
+    });
+
+  return match != size ? s_beg + match : nullptr;
+}
+
+inline void* FindRaw(Process const& process,
+                     std::uint8_t* s_beg,
+                     std::uint8_t* s_end,
+                     CompiledPattern const& pattern,
+                     std::uint32_t flags)
 {
   HADESMEM_DETAIL_ASSERT(s_beg < s_end);
 
   std::ptrdiff_t const mem_size = s_end - s_beg;
+  if (!!(flags & PatternFlags::kParallel) &&
+      static_cast<std::size_t>(mem_size) > kParallelScanChunkSize)
+  {
+    return FindRawParallel(process, s_beg, s_end, pattern);
+  }
+
   std::vector<std::uint8_t> const haystack{ReadVector<std::uint8_t>(
     process, s_beg, static_cast<std::size_t>(mem_size))};
 
-  auto const h_beg = std::begin(haystack);
-  auto const h_end = std::end(haystack);
-  auto const iter =
-    std::search(h_beg,
-                h_end,
-                n_beg,
-                n_end,
-                [](std::uint8_t h_cur, detail::PatternDataByte const& n_cur)
-                {
-      return n_cur.wildcard || h_cur == n_cur.data;
-    });
-
-  if (iter != h_end)
+  auto const h_beg = haystack.data();
+  auto const& searcher = pattern.GetSearcher();
+  if (auto const match = searcher.Search(h_beg, h_beg + haystack.size()))
   {
-    return s_beg + std::distance(h_beg, iter);
+    return s_beg + (match - h_beg);
   }
 
   return nullptr;
@@ -289,12 +422,10 @@ inline ModuleRegionInfo GetModuleInfo(Process const& process,
   return mod_info;
 }
 
-template <typename NeedleIterator>
-void* Find(Process const& process,
-           ModuleRegionInfo::ScanRegion const& region,
-           void* start,
-           NeedleIterator n_beg,
-           NeedleIterator n_end)
+// Returns the address to start scanning the region at, or nullptr if the
+// region should be skipped.
+inline std::uint8_t* GetScanStart(ModuleRegionInfo::ScanRegion const& region,
+                                  void* start)
 {
   std::uint8_t* s_beg = region.first;
   std::uint8_t* const s_end = region.second;
@@ -321,26 +452,214 @@ void* Find(Process const& process,
     }
   }
 
-  return FindRaw(process, s_beg, s_end, n_beg, n_end);
+  return s_beg;
+}
+
+inline void* Find(Process const& process,
+                  ModuleRegionInfo::ScanRegion const& region,
+                  void* start,
+                  CompiledPattern const& pattern,
+                  std::uint32_t flags)
+{
+  std::uint8_t* const s_beg = GetScanStart(region, start);
+  if (!s_beg)
+  {
+    return nullptr;
+  }
+
+  return FindRaw(process, s_beg, region.second, pattern, flags);
+}
+
+// Finds the first match in a local buffer, splitting the search across
+// threads if requested and the buffer is large enough.
+inline std::uint8_t const* SearchLocal(CompiledPattern const& pattern,
+                                       std::uint8_t const* h_beg,
+                                       std::uint8_t const* h_end,
+                                       std::uint32_t flags)
+{
+  auto const& searcher = pattern.GetSearcher();
+  std::size_t const size = static_cast<std::size_t>(h_end - h_beg);
+  if (!(flags & PatternFlags::kParallel) || size <= kParallelScanChunkSize)
+  {
+    return searcher.Search(h_beg, h_end);
+  }
+
+  std::size_t const offset = ParallelScan(
+    size,
+    kParallelScanChunkSize,
+    pattern.GetSize() - 1,
+    GetParallelScanThreadCount(),
+    [&](std::size_t chunk_offset, std::size_t chunk_length)
+    {
+      auto const chunk_beg = h_beg + chunk_offset;
+      auto const found = searcher.Search(chunk_beg, chunk_beg + chunk_length);
+      return found ? static_cast<std::size_t>(found - h_beg) : size;
+    });
+  return offset != size ? h_beg + offset : nullptr;
+}
+
+// Scans memory which is directly readable by the calling process (e.g. a
+// local buffer or a mapped file) in place, rather than copying it with
+// ReadProcessMemory first.
+inline void* FindLocal(std::vector<ModuleRegionInfo::ScanRegion> const& regions,
+                       std::uint8_t* base,
+                       CompiledPattern const& pattern,
+                       std::uint32_t flags,
+                       void* start,
+                       std::wstring const* name)
+{
+  for (auto const& region : regions)
+  {
+    std::uint8_t* const s_beg = GetScanStart(region, start);
+    if (!s_beg)
+    {
+      continue;
+    }
+
+    if (auto const match = SearchLocal(pattern, s_beg, region.second, flags))
+    {
+      auto const address = const_cast<std::uint8_t*>(match);
+      return !!(flags & PatternFlags::kRelativeAddress)
+               ? reinterpret_cast<void*>(address - base)
+               : address;
+    }
+  }
+
+  if (!!(flags & PatternFlags::kThrowOnUnmatch))
+  {
+    auto const name_narrow = name ? WideCharToMultiByte(*name) : std::string();
+    HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                    << ErrorString{"Could not match pattern."}
+                                    << ErrorStringOther{name_narrow});
+  }
+
+  return nullptr;
+}
+
+// Counts every (possibly overlapping) match in memory which is directly
+// readable by the calling process.
+inline std::size_t
+  CountMatchesLocal(std::vector<ModuleRegionInfo::ScanRegion> const& regions,
+                    CompiledPattern const& pattern)
+{
+  auto const& searcher = pattern.GetSearcher();
+  std::size_t count = 0;
+  for (auto const& region : regions)
+  {
+    std::uint8_t const* cur = region.first;
+    while (auto const match = searcher.Search(cur, region.second))
+    {
+      ++count;
+      cur = match + 1;
+    }
+  }
+
+  return count;
+}
+
+// Gets the raw data of the code sections (or the initialized data sections)
+// of a PE file which is mapped as a flat file at base.
+inline std::vector<ModuleRegionInfo::ScanRegion>
+  GetPeFileScanRegions(Process const& process,
+                       std::uint8_t* base,
+                       std::size_t size,
+                       bool scan_data_secs)
+{
+  PeFile const pe_file{
+    process, base, PeFileType::Data, static_cast<DWORD>(size)};
+  SectionList const sections{process, pe_file};
+  std::vector<ModuleRegionInfo::ScanRegion> regions;
+  for (auto const& s : sections)
+  {
+    DWORD const characteristics = s.GetCharacteristics();
+    bool const is_code_section = !!(characteristics & IMAGE_SCN_CNT_CODE);
+    bool const is_data_section =
+      !!(characteristics & IMAGE_SCN_CNT_INITIALIZED_DATA);
+    if (scan_data_secs ? (is_code_section || !is_data_section)
+                       : !is_code_section)
+    {
+      continue;
+    }
+
+    std::size_t const raw_beg = s.GetPointerToRawData();
+    std::size_t const raw_end =
+      (std::min)(raw_beg + s.GetSizeOfRawData(), size);
+    if (raw_beg >= raw_end)
+    {
+      continue;
+    }
+
+    regions.emplace_back(base + raw_beg, base + raw_end);
+  }
+
+  return regions;
 }
 
-template <typename NeedleIterator>
-void* Find(Process const& process,
-           ModuleRegionInfo const& mod_info,
-           NeedleIterator n_beg,
-           NeedleIterator n_end,
-           std::uint32_t flags,
-           void* start,
-           std::wstring const* name)
+class MappedFileView
 {
-  HADESMEM_DETAIL_ASSERT(n_beg != n_end);
+public:
+  explicit MappedFileView(std::wstring const& path)
+    : file_{::CreateFileW(path.c_str(),
+                          GENERIC_READ,
+                          FILE_SHARE_READ,
+                          nullptr,
+                          OPEN_EXISTING,
+                          0,
+                          nullptr)}
+  {
+    if (!file_.IsValid())
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"CreateFileW failed."}
+                                      << ErrorCodeWinLast{last_error});
+    }
+
+    file_mapping_ = ::CreateFileMappingW(
+      file_.GetHandle(), nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!file_mapping_.IsValid())
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"CreateFileMappingW failed."}
+                << ErrorCodeWinLast{last_error});
+    }
+
+    file_view_ =
+      ::MapViewOfFile(file_mapping_.GetHandle(), FILE_MAP_READ, 0, 0, 0);
+    if (!file_view_.IsValid())
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"MapViewOfFile failed."}
+                                      << ErrorCodeWinLast{last_error});
+    }
+  }
+
+  void* GetBase() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return file_view_.GetHandle();
+  }
+
+private:
+  SmartFileHandle file_;
+  SmartHandle file_mapping_;
+  SmartMappedFileHandle file_view_;
+};
 
+inline void* Find(Process const& process,
+                  ModuleRegionInfo const& mod_info,
+                  CompiledPattern const& pattern,
+                  std::uint32_t flags,
+                  void* start,
+                  std::wstring const* name)
+{
   bool const scan_data_secs = !!(flags & PatternFlags::kScanData);
   auto const& scan_regions =
     scan_data_secs ? mod_info.data_regions : mod_info.code_regions;
   for (auto const& region : scan_regions)
   {
-    if (void* const address = Find(process, region, start, n_beg, n_end))
+    if (void* const address = Find(process, region, start, pattern, flags))
     {
       return !!(flags & PatternFlags::kRelativeAddress)
                ? static_cast<std::uint8_t*>(address) -
@@ -361,18 +680,14 @@ void* Find(Process const& process,
   return nullptr;
 }
 
-template <typename NeedleIterator>
-void* Find(Process const& process,
-           std::pair<std::uint8_t*, std::uint8_t*> const& region,
-           NeedleIterator n_beg,
-           NeedleIterator n_end,
-           std::uint32_t flags,
-           void* start,
-           std::wstring const* name)
+inline void* Find(Process const& process,
+                  std::pair<std::uint8_t*, std::uint8_t*> const& region,
+                  CompiledPattern const& pattern,
+                  std::uint32_t flags,
+                  void* start,
+                  std::wstring const* name)
 {
-  HADESMEM_DETAIL_ASSERT(n_beg != n_end);
-
-  if (void* const address = Find(process, region, start, n_beg, n_end))
+  if (void* const address = Find(process, region, start, pattern, flags))
   {
     return !!(flags & PatternFlags::kRelativeAddress)
              ? static_cast<std::uint8_t*>(address) -
@@ -390,11 +705,153 @@ void* Find(Process const& process,
 
   return nullptr;
 }
+
+// Reads each region of a module at most once, so that any number of patterns
+// can be matched against the same local copy.
+class ModuleRegionCache
+{
+public:
+  explicit ModuleRegionCache(Process const& process) : process_{&process}
+  {
+  }
+
+  explicit ModuleRegionCache(Process&& process) = delete;
+
+  std::vector<std::uint8_t> const&
+    GetRegionData(ModuleRegionInfo::ScanRegion const& region)
+  {
+    auto iter = buffers_.find(region.first);
+    if (iter == std::end(buffers_))
+    {
+      HADESMEM_DETAIL_ASSERT(region.first < region.second);
+      std::size_t const size =
+        static_cast<std::size_t>(region.second - region.first);
+      iter = buffers_.emplace(region.first,
+                              ReadVector<std::uint8_t>(
+                                *process_, region.first, size)).first;
+    }
+
+    return iter->second;
+  }
+
+private:
+  Process const* process_;
+  std::map<std::uint8_t*, std::vector<std::uint8_t>> buffers_;
+};
+
+struct FindBatchRequest
+{
+  CompiledPattern const* pattern;
+  std::uint32_t flags;
+  void* start;
+  std::wstring const* name;
+};
+
+// Equivalent to calling Find for every request, except that each region is
+// scanned once for all of the requests interested in it.
+inline std::vector<void*>
+  FindBatch(ModuleRegionInfo const& mod_info,
+            ModuleRegionCache& region_cache,
+            std::vector<FindBatchRequest> const& requests)
+{
+  std::vector<void*> results(requests.size());
+  std::vector<bool> matched(requests.size());
+
+  auto const scan_regions =
+    [&](std::vector<ModuleRegionInfo::ScanRegion> const& regions,
+        bool scan_data_secs)
+  {
+    for (auto const& region : regions)
+    {
+      MultiPatternMatcher matcher;
+      std::vector<std::size_t> ids;
+
+      for (std::size_t i = 0; i < requests.size(); ++i)
+      {
+        auto const& request = requests[i];
+        if (matched[i] ||
+            !!(request.flags & PatternFlags::kScanData) != scan_data_secs)
+        {
+          continue;
+        }
+
+        // Mirror the custom start address semantics of the single pattern
+        // Find (only the region containing the start address is scanned).
+        std::size_t min_offset = 0;
+        if (request.start)
+        {
+          auto const start = static_cast<std::uint8_t*>(request.start);
+          if (start < region.first || start >= region.second)
+          {
+            continue;
+          }
+
+          if (start + 1 == region.second)
+          {
+            HADESMEM_DETAIL_THROW_EXCEPTION(
+              Error() << ErrorString("Invalid start address."));
+          }
+
+          min_offset = static_cast<std::size_t>(start + 1 - region.first);
+        }
+
+        auto const& needle = request.pattern->GetData();
+        matcher.Add(
+          needle.data(), needle.data() + needle.size(), min_offset);
+        ids.push_back(i);
+      }
+
+      if (ids.empty())
+      {
+        continue;
+      }
+
+      auto const& haystack = region_cache.GetRegionData(region);
+      auto const offsets =
+        matcher.Search(haystack.data(), haystack.data() + haystack.size());
+      for (std::size_t j = 0; j < ids.size(); ++j)
+      {
+        if (offsets[j] != MultiPatternMatcher::kNoMatch)
+        {
+          matched[ids[j]] = true;
+          results[ids[j]] = region.first + offsets[j];
+        }
+      }
+    }
+  };
+
+  scan_regions(mod_info.code_regions, false);
+  scan_regions(mod_info.data_regions, true);
+
+  auto const base =
+    reinterpret_cast<std::uintptr_t>(mod_info.module->GetHandle());
+  for (std::size_t i = 0; i < requests.size(); ++i)
+  {
+    auto const& request = requests[i];
+    if (matched[i])
+    {
+      if (!!(request.flags & PatternFlags::kRelativeAddress))
+      {
+        results[i] = static_cast<std::uint8_t*>(results[i]) - base;
+      }
+    }
+    else if (!!(request.flags & PatternFlags::kThrowOnUnmatch))
+    {
+      auto const name_narrow =
+        request.name ? WideCharToMultiByte(*request.name) : std::string();
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Could not match pattern."}
+                                      << ErrorStringOther{name_narrow});
+    }
+  }
+
+  return results;
+}
 }
 
 inline void* Find(Process const& process,
                   std::wstring const& module,
-                  std::wstring const& data,
+                  CompiledPattern const& pattern,
                   std::uint32_t flags,
                   std::uintptr_t start,
                   std::wstring const* name = nullptr)
@@ -403,24 +860,27 @@ inline void* Find(Process const& process,
     !(flags & ~(PatternFlags::kInvalidFlagMaxValue - 1UL)));
 
   auto const mod_info = detail::GetModuleInfo(process, module);
-  auto const needle = detail::ConvertData(data);
   void* const start_abs =
     start
       ? reinterpret_cast<std::uint8_t*>(mod_info.module->GetHandle()) + start
       : nullptr;
-  return detail::Find(process,
-                      mod_info,
-                      std::begin(needle),
-                      std::end(needle),
-                      flags,
-                      start_abs,
-                      name);
+  return detail::Find(process, mod_info, pattern, flags, start_abs, name);
+}
+
+inline void* Find(Process const& process,
+                  std::wstring const& module,
+                  std::wstring const& data,
+                  std::uint32_t flags,
+                  std::uintptr_t start,
+                  std::wstring const* name = nullptr)
+{
+  return Find(process, module, CompiledPattern{data}, flags, start, name);
 }
 
 inline void* Find(Process const& process,
                   void* base,
                   std::size_t size,
-                  std::wstring const& data,
+                  CompiledPattern const& pattern,
                   std::uint32_t flags,
                   std::uintptr_t start,
                   std::wstring const* name = nullptr)
@@ -430,15 +890,66 @@ inline void* Find(Process const& process,
 
   auto const region = std::make_pair(static_cast<std::uint8_t*>(base),
                                      static_cast<std::uint8_t*>(base) + size);
-  auto const needle = detail::ConvertData(data);
   void* const start_abs = start ? region.first + start : nullptr;
-  return detail::Find(process,
-                      region,
-                      std::begin(needle),
-                      std::end(needle),
-                      flags,
-                      start_abs,
-                      name);
+  return detail::Find(process, region, pattern, flags, start_abs, name);
+}
+
+inline void* Find(Process const& process,
+                  void* base,
+                  std::size_t size,
+                  std::wstring const& data,
+                  std::uint32_t flags,
+                  std::uintptr_t start,
+                  std::wstring const* name = nullptr)
+{
+  return Find(process, base, size, CompiledPattern{data}, flags, start, name);
+}
+
+// Scans a buffer which is readable by the calling process in place. Relative
+// addresses are relative to the start of the buffer.
+inline void* FindInBuffer(void const* base,
+                          std::size_t size,
+                          CompiledPattern const& pattern,
+                          std::uint32_t flags,
+                          std::uintptr_t start,
+                          std::wstring const* name = nullptr)
+{
+  HADESMEM_DETAIL_ASSERT(
+    !(flags & ~(PatternFlags::kInvalidFlagMaxValue - 1UL)));
+
+  auto const region_beg =
+    static_cast<std::uint8_t*>(const_cast<void*>(base));
+  std::vector<detail::ModuleRegionInfo::ScanRegion> const regions{
+    std::make_pair(region_beg, region_beg + size)};
+  void* const start_abs = start ? region_beg + start : nullptr;
+  return detail::FindLocal(
+    regions, region_beg, pattern, flags, start_abs, name);
+}
+
+inline void* FindInBuffer(void const* base,
+                          std::size_t size,
+                          std::wstring const& data,
+                          std::uint32_t flags,
+                          std::uintptr_t start,
+                          std::wstring const* name = nullptr)
+{
+  return FindInBuffer(base, size, CompiledPattern{data}, flags, start, name);
+}
+
+inline void* FindInFile(Process const& process,
+                        std::wstring const& path,
+                        CompiledPattern const& pattern,
+                        std::uint32_t flags,
+                        std::uintptr_t start,
+                        std::wstring const* name = nullptr)
+{
+  HADESMEM_DETAIL_ASSERT(
+    !(flags & ~(PatternFlags::kInvalidFlagMaxValue - 1UL)));
+
+  detail::MappedFileView const file_view{path};
+  auto const base = file_view.GetBase();
+  auto const size = detail::GetRegionAllocSize(process, base);
+  return FindInBuffer(base, size, pattern, flags, start, name);
 }
 
 inline void* FindInFile(Process const& process,
@@ -447,48 +958,340 @@ inline void* FindInFile(Process const& process,
                         std::uint32_t flags,
                         std::uintptr_t start,
                         std::wstring const* name = nullptr)
+{
+  return FindInFile(process, path, CompiledPattern{data}, flags, start, name);
+}
+
+// Like FindInFile, but only scans the raw data of the code sections (or the
+// initialized data sections if kScanData is specified) of a PE file, in the
+// same way a module is scanned. Relative addresses are file offsets.
+inline void* FindInPeFile(Process const& process,
+                          std::wstring const& path,
+                          CompiledPattern const& pattern,
+                          std::uint32_t flags,
+                          std::uintptr_t start,
+                          std::wstring const* name = nullptr)
 {
   HADESMEM_DETAIL_ASSERT(
     !(flags & ~(PatternFlags::kInvalidFlagMaxValue - 1UL)));
 
-  detail::SmartFileHandle const file{::CreateFileW(path.c_str(),
-                                                   GENERIC_READ,
-                                                   FILE_SHARE_READ,
-                                                   nullptr,
-                                                   OPEN_EXISTING,
-                                                   0,
-                                                   nullptr)};
-  if (!file.IsValid())
+  detail::MappedFileView const file_view{path};
+  auto const base = static_cast<std::uint8_t*>(file_view.GetBase());
+  auto const size = detail::GetRegionAllocSize(process, base);
+  auto const regions = detail::GetPeFileScanRegions(
+    process, base, size, !!(flags & PatternFlags::kScanData));
+  void* const start_abs = start ? base + start : nullptr;
+  return detail::FindLocal(regions, base, pattern, flags, start_abs, name);
+}
+
+inline void* FindInPeFile(Process const& process,
+                          std::wstring const& path,
+                          std::wstring const& data,
+                          std::uint32_t flags,
+                          std::uintptr_t start,
+                          std::wstring const* name = nullptr)
+{
+  return FindInPeFile(
+    process, path, CompiledPattern{data}, flags, start, name);
+}
+
+namespace detail
+{
+struct PatternMatchListData
+{
+  Process const* process;
+  std::vector<ModuleRegionInfo::ScanRegion> regions;
+  CompiledPattern pattern;
+  std::uint32_t flags;
+  std::uint8_t* base;
+  std::size_t max_matches;
+  std::wstring name;
+};
+}
+
+// PatternMatchIterator satisfies the requirements of an input iterator
+// (C++ Standard, 24.2.1, Input Iterators [input.iterators]). Each region is
+// read once, when the iterator first reaches it, and matches are then found
+// incrementally in the local copy.
+class PatternMatchIterator
+  : public std::iterator<std::input_iterator_tag, void*>
+{
+public:
+  using BaseIteratorT = std::iterator<std::input_iterator_tag, void*>;
+  using value_type = BaseIteratorT::value_type;
+  using difference_type = BaseIteratorT::difference_type;
+  using pointer = BaseIteratorT::pointer;
+  using reference = BaseIteratorT::reference;
+  using iterator_category = BaseIteratorT::iterator_category;
+
+  HADESMEM_DETAIL_CONSTEXPR PatternMatchIterator() HADESMEM_DETAIL_NOEXCEPT
   {
-    DWORD const last_error = ::GetLastError();
-    HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
-                                    << ErrorString{"CreateFileW failed."}
-                                    << ErrorCodeWinLast{last_error});
   }
 
-  detail::SmartHandle const file_mapping{::CreateFileMappingW(
-    file.GetHandle(), nullptr, PAGE_READONLY, 0, 0, nullptr) };
-  if (!file_mapping.IsValid())
+  explicit PatternMatchIterator(
+    std::shared_ptr<detail::PatternMatchListData const> const& data)
+    : impl_{std::make_shared<Impl>(data)}
   {
-    DWORD const last_error = ::GetLastError();
-    HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
-                                    << ErrorString{"CreateFileMappingW failed."}
-                                    << ErrorCodeWinLast{last_error});
+    if (!Advance())
+    {
+      impl_.reset();
+
+      if (!!(data->flags & PatternFlags::kThrowOnUnmatch))
+      {
+        auto const name_narrow = detail::WideCharToMultiByte(data->name);
+        HADESMEM_DETAIL_THROW_EXCEPTION(
+          Error{} << ErrorString{"Could not match pattern."}
+                  << ErrorStringOther{name_narrow});
+      }
+    }
   }
 
-  detail::SmartMappedFileHandle const file_view{
-    ::MapViewOfFile(file_mapping.GetHandle(), FILE_MAP_READ, 0, 0, 0)};
-  if (!file_view.IsValid())
+#if defined(HADESMEM_DETAIL_NO_RVALUE_REFERENCES_V3)
+
+  PatternMatchIterator(PatternMatchIterator const&) = default;
+
+  PatternMatchIterator& operator=(PatternMatchIterator const&) = default;
+
+  PatternMatchIterator(PatternMatchIterator&& other) HADESMEM_DETAIL_NOEXCEPT
+    : impl_{std::move(other.impl_)}
   {
-    DWORD const last_error = ::GetLastError();
-    HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
-                                    << ErrorString{"MapViewOfFile failed."}
-                                    << ErrorCodeWinLast{last_error});
   }
 
-  auto const base = file_view.GetHandle();
-  auto const size = detail::GetRegionAllocSize(process, base);
-  return Find(process, base, size, data, flags, start, name);
+  PatternMatchIterator&
+    operator=(PatternMatchIterator&& other) HADESMEM_DETAIL_NOEXCEPT
+  {
+    impl_ = std::move(other.impl_);
+
+    return *this;
+  }
+
+#endif // #if defined(HADESMEM_DETAIL_NO_RVALUE_REFERENCES_V3)
+
+  reference operator*() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    HADESMEM_DETAIL_ASSERT(impl_.get());
+    return impl_->match_;
+  }
+
+  pointer operator->() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    HADESMEM_DETAIL_ASSERT(impl_.get());
+    return &impl_->match_;
+  }
+
+  PatternMatchIterator& operator++()
+  {
+    HADESMEM_DETAIL_ASSERT(impl_.get());
+
+    if (!Advance())
+    {
+      impl_.reset();
+    }
+
+    return *this;
+  }
+
+  PatternMatchIterator operator++(int)
+  {
+    PatternMatchIterator const iter{*this};
+    ++*this;
+    return iter;
+  }
+
+  bool operator==(PatternMatchIterator const& other) const
+    HADESMEM_DETAIL_NOEXCEPT
+  {
+    return impl_ == other.impl_;
+  }
+
+  bool operator!=(PatternMatchIterator const& other) const
+    HADESMEM_DETAIL_NOEXCEPT
+  {
+    return !(*this == other);
+  }
+
+private:
+  bool Advance()
+  {
+    auto& impl = *impl_;
+    auto const& data = *impl.data_;
+    if (data.max_matches && impl.num_matches_ == data.max_matches)
+    {
+      return false;
+    }
+
+    for (; impl.region_ < data.regions.size(); ++impl.region_)
+    {
+      auto const& region = data.regions[impl.region_];
+      if (!impl.region_read_)
+      {
+        impl.haystack_ = ReadVector<std::uint8_t>(
+          *data.process,
+          region.first,
+          static_cast<std::size_t>(region.second - region.first));
+        impl.offset_ = 0;
+        impl.region_read_ = true;
+      }
+
+      auto const h_beg = impl.haystack_.data();
+      auto const h_end = h_beg + impl.haystack_.size();
+      if (auto const match = detail::SearchLocal(
+            data.pattern, h_beg + impl.offset_, h_end, data.flags))
+      {
+        // Resume one byte past this match, so overlapping matches are
+        // reported just as they would be by repeated calls to Find.
+        std::size_t const offset = static_cast<std::size_t>(match - h_beg);
+        impl.offset_ = offset + 1;
+        ++impl.num_matches_;
+
+        std::uint8_t* const address = region.first + offset;
+        impl.match_ = !!(data.flags & PatternFlags::kRelativeAddress)
+                        ? reinterpret_cast<void*>(address - data.base)
+                        : address;
+        return true;
+      }
+
+      impl.haystack_.clear();
+      impl.region_read_ = false;
+    }
+
+    return false;
+  }
+
+  struct Impl
+  {
+    explicit Impl(
+      std::shared_ptr<detail::PatternMatchListData const> const& data)
+      HADESMEM_DETAIL_NOEXCEPT : data_{data}
+    {
+    }
+
+    std::shared_ptr<detail::PatternMatchListData const> data_;
+    std::vector<std::uint8_t> haystack_;
+    std::size_t region_{};
+    std::size_t offset_{};
+    std::size_t num_matches_{};
+    bool region_read_{};
+    void* match_{};
+  };
+
+  // Shallow copy semantics, as required by InputIterator.
+  std::shared_ptr<Impl> impl_;
+};
+
+// Lazy range over every match of a pattern. Nothing is read until begin() is
+// called, and every call to begin() starts a new scan.
+class PatternMatchList
+{
+public:
+  using value_type = void*;
+  using iterator = PatternMatchIterator;
+  using const_iterator = PatternMatchIterator;
+
+  explicit PatternMatchList(
+    std::shared_ptr<detail::PatternMatchListData const> const& data)
+    : data_{data}
+  {
+  }
+
+  iterator begin() const
+  {
+    return iterator(data_);
+  }
+
+  const_iterator cbegin() const
+  {
+    return const_iterator(data_);
+  }
+
+  iterator end() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return iterator();
+  }
+
+  const_iterator cend() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return const_iterator();
+  }
+
+private:
+  std::shared_ptr<detail::PatternMatchListData const> data_;
+};
+
+// Finds every match of the pattern (at most max_matches if it is non-zero).
+// The process must outlive the returned range. With kParallel, the search
+// within each large region is split across threads (each region is still read
+// in one call).
+inline PatternMatchList FindAll(Process const& process,
+                                std::wstring const& module,
+                                CompiledPattern const& pattern,
+                                std::uint32_t flags,
+                                std::size_t max_matches = 0,
+                                std::wstring const* name = nullptr)
+{
+  HADESMEM_DETAIL_ASSERT(
+    !(flags & ~(PatternFlags::kInvalidFlagMaxValue - 1UL)));
+
+  auto const mod_info = detail::GetModuleInfo(process, module);
+  bool const scan_data_secs = !!(flags & PatternFlags::kScanData);
+  auto const data = std::make_shared<detail::PatternMatchListData>(
+    detail::PatternMatchListData{
+      &process,
+      scan_data_secs ? mod_info.data_regions : mod_info.code_regions,
+      pattern,
+      flags,
+      reinterpret_cast<std::uint8_t*>(mod_info.module->GetHandle()),
+      max_matches,
+      name ? *name : std::wstring()});
+  return PatternMatchList{data};
+}
+
+inline PatternMatchList FindAll(Process const& process,
+                                std::wstring const& module,
+                                std::wstring const& data,
+                                std::uint32_t flags,
+                                std::size_t max_matches = 0,
+                                std::wstring const* name = nullptr)
+{
+  return FindAll(
+    process, module, CompiledPattern{data}, flags, max_matches, name);
+}
+
+inline PatternMatchList FindAll(Process const& process,
+                                void* base,
+                                std::size_t size,
+                                CompiledPattern const& pattern,
+                                std::uint32_t flags,
+                                std::size_t max_matches = 0,
+                                std::wstring const* name = nullptr)
+{
+  HADESMEM_DETAIL_ASSERT(
+    !(flags & ~(PatternFlags::kInvalidFlagMaxValue - 1UL)));
+
+  auto const region_beg = static_cast<std::uint8_t*>(base);
+  std::vector<detail::ModuleRegionInfo::ScanRegion> const regions{
+    std::make_pair(region_beg, region_beg + size)};
+  auto const data = std::make_shared<detail::PatternMatchListData>(
+    detail::PatternMatchListData{&process,
+                                 regions,
+                                 pattern,
+                                 flags,
+                                 region_beg,
+                                 max_matches,
+                                 name ? *name : std::wstring()});
+  return PatternMatchList{data};
+}
+
+inline PatternMatchList FindAll(Process const& process,
+                                void* base,
+                                std::size_t size,
+                                std::wstring const& data,
+                                std::uint32_t flags,
+                                std::size_t max_matches = 0,
+                                std::wstring const* name = nullptr)
+{
+  return FindAll(
+    process, base, size, CompiledPattern{data}, flags, max_matches, name);
 }
 
 class Pattern
@@ -707,14 +1510,68 @@ private:
   std::map<std::wstring, PatternMap> map_;
 };
 
+struct FindPatternFlags
+{
+  enum : std::uint32_t
+  {
+    kNone = 0,
+    kLazy = 1 << 0,
+    kInvalidFlagMaxValue = 1 << 1
+  };
+};
+
 class FindPattern
 {
 public:
   explicit FindPattern(Process const& process,
                        std::wstring const& pattern_file,
                        bool in_memory_file)
-    : process_{&process}, find_pattern_datas_{}
+    : FindPattern{
+        process, pattern_file, in_memory_file, FindPatternFlags::kNone}
   {
+  }
+
+  explicit FindPattern(Process const& process,
+                       std::wstring const& pattern_file,
+                       bool in_memory_file,
+                       std::wstring const& cache_path)
+    : FindPattern{process,
+                  pattern_file,
+                  in_memory_file,
+                  FindPatternFlags::kNone,
+                  cache_path}
+  {
+  }
+
+  // With kLazy the patterns for a module are only resolved when the module is
+  // first looked up (or passed to ResolveModule), so modules which are never
+  // used are never scanned. If cache_path is not empty, results are looked up
+  // in (and new results are added to) the cache file at cache_path, keyed by
+  // module identity and pattern definition, so modules which have not changed
+  // since the last run need not be scanned.
+  // Lookups may resolve modules (and so modify the object) even though they
+  // are const, so they are serialized with an internal lock. GetModuleMap is
+  // not covered by the lock.
+  explicit FindPattern(Process const& process,
+                       std::wstring const& pattern_file,
+                       bool in_memory_file,
+                       std::uint32_t flags,
+                       std::wstring const& cache_path = std::wstring())
+    : process_{&process},
+      cache_path_(cache_path),
+      pending_modules_{},
+      find_pattern_datas_{},
+      mutex_{std::make_shared<std::mutex>()}
+  {
+    HADESMEM_DETAIL_ASSERT(
+      !(flags & ~(FindPatternFlags::kInvalidFlagMaxValue - 1UL)));
+
+    if (!cache_path_.empty())
+    {
+      cache_ = std::make_shared<detail::PatternCache>();
+      cache_->LoadFile(cache_path_);
+    }
+
     if (in_memory_file)
     {
       LoadPatternFileMemory(pattern_file);
@@ -723,12 +1580,30 @@ public:
     {
       LoadPatternFile(pattern_file);
     }
+
+    if (!(flags & FindPatternFlags::kLazy))
+    {
+      ResolveAll();
+      cache_.reset();
+    }
   }
 
   explicit FindPattern(Process&& process,
                        std::wstring const& pattern,
                        bool in_memory_file) = delete;
 
+  explicit FindPattern(Process&& process,
+                       std::wstring const& pattern,
+                       bool in_memory_file,
+                       std::wstring const& cache_path) = delete;
+
+  explicit FindPattern(Process&& process,
+                       std::wstring const& pattern,
+                       bool in_memory_file,
+                       std::uint32_t flags,
+                       std::wstring const& cache_path = std::wstring()) =
+    delete;
+
 #if defined(HADESMEM_DETAIL_NO_RVALUE_REFERENCES_V3)
 
   FindPattern(FindPattern const&) = default;
@@ -737,7 +1612,11 @@ public:
 
   FindPattern(FindPattern&& other)
     : process_{other.process_},
-      find_pattern_datas_{std::move(other.find_pattern_datas_)}
+      cache_(std::move(other.cache_)),
+      cache_path_(std::move(other.cache_path_)),
+      pending_modules_{std::move(other.pending_modules_)},
+      find_pattern_datas_{std::move(other.find_pattern_datas_)},
+      mutex_{std::move(other.mutex_)}
   {
     other.process_ = nullptr;
   }
@@ -747,13 +1626,19 @@ public:
     process_ = other.process_;
     other.process_ = nullptr;
 
+    cache_ = std::move(other.cache_);
+    cache_path_ = std::move(other.cache_path_);
+    pending_modules_ = std::move(other.pending_modules_);
     find_pattern_datas_ = std::move(other.find_pattern_datas_);
+    mutex_ = std::move(other.mutex_);
 
     return *this;
   }
 
 #endif // #if defined(HADESMEM_DETAIL_NO_RVALUE_REFERENCES_V3)
 
+  // Only contains the modules which have been resolved so far. Must not be
+  // used while another thread may be resolving modules.
   ModuleMap const& GetModuleMap() const HADESMEM_DETAIL_NOEXCEPT
   {
     return find_pattern_datas_;
@@ -761,9 +1646,15 @@ public:
 
   PatternMap const& GetPatternMap(std::wstring const& module) const
   {
+    auto const module_upper = detail::ToUpperOrdinal(module);
+    std::lock_guard<std::mutex> const lock{*mutex_};
+    ResolvePendingModule(module_upper);
+
+    // Elements of the map are never removed or moved, so the reference stays
+    // valid after the lock is released.
     try
     {
-      return find_pattern_datas_.at(detail::ToUpperOrdinal(module));
+      return find_pattern_datas_.at(module_upper);
     }
     catch (std::out_of_range const&)
     {
@@ -777,6 +1668,25 @@ public:
     return LookupEx(module, name).GetAddress();
   }
 
+  // Resolves the patterns for a module if that has not already happened
+  // (e.g. in response to a module load notification). The module must be
+  // loaded.
+  void ResolveModule(std::wstring const& module)
+  {
+    auto const module_upper = detail::ToUpperOrdinal(module);
+    std::lock_guard<std::mutex> const lock{*mutex_};
+    ResolvePendingModule(module_upper);
+  }
+
+  void ResolveAll()
+  {
+    std::lock_guard<std::mutex> const lock{*mutex_};
+    while (!pending_modules_.empty())
+    {
+      ResolvePendingModule(std::begin(pending_modules_)->first);
+    }
+  }
+
   friend bool operator==(FindPattern const& lhs, FindPattern const& rhs)
   {
     return lhs.process_ == rhs.process_ &&
@@ -837,6 +1747,7 @@ private:
   {
     std::wstring name;
     std::wstring data;
+    CompiledPattern compiled;
     std::wstring start;
     std::wstring start_rva;
     std::wstring start_export;
@@ -948,6 +1859,7 @@ private:
 
         PatternInfo pattern_info{pattern_name,
                                  pattern_data,
+                                 CompiledPattern{pattern_data},
                                  pattern_start,
                                  pattern_start_rva,
                                  pattern_start_export,
@@ -1092,19 +2004,14 @@ private:
     return address;
   }
 
-  std::uintptr_t GetStartRvaFromPattern(std::wstring const& module,
-                                        std::uintptr_t base,
-                                        std::wstring const& start) const
+  std::uintptr_t GetStartRvaFromPattern(std::uintptr_t base,
+                                        Pattern const& start_pattern) const
   {
-    std::uintptr_t start_rva = 0U;
-    if (!start.empty())
+    std::uintptr_t start_rva =
+      reinterpret_cast<std::uintptr_t>(start_pattern.GetAddress());
+    if (!(start_pattern.GetFlags() & PatternFlags::kRelativeAddress))
     {
-      Pattern const start_pattern = LookupEx(module, start);
-      start_rva = reinterpret_cast<std::uintptr_t>(start_pattern.GetAddress());
-      if (!(start_pattern.GetFlags() & PatternFlags::kRelativeAddress))
-      {
-        start_rva -= base;
-      }
+      start_rva -= base;
     }
 
     return start_rva;
@@ -1134,26 +2041,153 @@ private:
     return start_rva;
   }
 
+  // Patterns which use another pattern as their start address can only be
+  // scanned for once that pattern has been resolved, so patterns are grouped
+  // into 'waves' by dependency depth and each wave is scanned as one batch.
+  std::vector<std::size_t>
+    GetPatternWaves(std::vector<PatternInfoFull> const& pattern_infos,
+                    std::vector<std::size_t>& deps) const
+  {
+    std::size_t const kNoDep = static_cast<std::size_t>(-1);
+    deps.assign(pattern_infos.size(), kNoDep);
+    std::vector<std::size_t> waves(pattern_infos.size(), 0);
+    for (std::size_t i = 0; i < pattern_infos.size(); ++i)
+    {
+      auto const& p = pattern_infos[i].pattern;
+      if (!p.start_rva.empty() || !p.start_export.empty() || p.start.empty())
+      {
+        continue;
+      }
+
+      // Only patterns defined earlier in the file are visible, and the most
+      // recent definition of a name wins.
+      for (std::size_t j = i; j-- > 0;)
+      {
+        if (pattern_infos[j].pattern.name == p.start)
+        {
+          deps[i] = j;
+          waves[i] = waves[j] + 1;
+          break;
+        }
+      }
+
+      if (deps[i] == kNoDep)
+      {
+        HADESMEM_DETAIL_THROW_EXCEPTION(
+          Error{} << ErrorString{"Invalid pattern name."});
+      }
+    }
+
+    return waves;
+  }
+
+  // Hash of everything which determines a pattern's result other than the
+  // module itself. The resolved start address is included (rather than just
+  // how it is specified) as it can change while the module doesn't, e.g. when
+  // it comes from a forwarded export or a start pattern with manipulators.
+  std::uint64_t GetPatternCacheKey(std::uint32_t flags,
+                                   PatternInfoFull const& p,
+                                   std::uintptr_t start_rva) const
+  {
+    auto const hash_str = [](std::uint64_t h, std::wstring const& str)
+    {
+      std::uint64_t const len = str.size();
+      h = detail::HashFnv1a64(&len, sizeof(len), h);
+      return detail::HashFnv1a64(str.data(), str.size() * sizeof(wchar_t), h);
+    };
+
+    std::uint64_t key = detail::HashFnv1a64(&flags, sizeof(flags));
+    key = hash_str(key, p.pattern.data);
+    key = hash_str(key, p.pattern.start);
+    key = hash_str(key, p.pattern.start_rva);
+    key = hash_str(key, p.pattern.start_export);
+    std::uint64_t const start = start_rva;
+    key = detail::HashFnv1a64(&start, sizeof(start), key);
+    for (auto const& m : p.manipulators)
+    {
+      std::uint64_t const manip[] = {static_cast<std::uint64_t>(m.type),
+                                     m.has_operand1,
+                                     m.operand1,
+                                     m.has_operand2,
+                                     m.operand2};
+      key = detail::HashFnv1a64(manip, sizeof(manip), key);
+    }
+
+    return key;
+  }
+
   void LoadPatternFileImpl(pugi::xml_document const& doc)
   {
-    auto const patterns_info_full_list = ReadPatternsFromXml(doc);
-    for (auto const& patterns_info_full_pair : patterns_info_full_list)
+    pending_modules_ = ReadPatternsFromXml(doc);
+  }
+
+  // The caller must hold the lock.
+  void ResolvePendingModule(std::wstring const& module_name) const
+  {
+    auto const pending_iter = pending_modules_.find(module_name);
+    if (pending_iter == std::end(pending_modules_))
+    {
+      return;
+    }
+
+    ResolveModulePatterns(module_name, pending_iter->second, cache_.get());
+    pending_modules_.erase(pending_iter);
+
+    if (cache_ && cache_->IsDirty())
+    {
+      cache_->SaveFile(cache_path_);
+    }
+  }
+
+  void ResolveModulePatterns(std::wstring const& module_name,
+                             FindPatternInfo const& patterns_info_full,
+                             detail::PatternCache* cache) const
+  {
+    HADESMEM_DETAIL_ASSERT(find_pattern_datas_.find(module_name) ==
+                           std::end(find_pattern_datas_));
+
+    auto const mod_info = detail::GetModuleInfo(*process_, module_name);
+    auto const base =
+      reinterpret_cast<std::uintptr_t>(mod_info.module->GetHandle());
+    auto const& pattern_infos = patterns_info_full.patterns;
+
+    std::vector<std::size_t> deps;
+    auto const waves = GetPatternWaves(pattern_infos, deps);
+    std::size_t const num_waves =
+      waves.empty() ? 0 : *std::max_element(std::begin(waves),
+                                            std::end(waves)) + 1;
+
+    detail::ModuleRegionCache region_cache{*process_};
+    std::vector<Pattern> patterns(pattern_infos.size());
+
+    detail::PatternCache::ModuleId module_id{};
+    std::vector<std::uint64_t> cache_keys(pattern_infos.size());
+    if (cache)
     {
-      HADESMEM_DETAIL_ASSERT(
-        find_pattern_datas_.find(patterns_info_full_pair.first) ==
-        std::end(find_pattern_datas_));
-
-      auto const mod_info =
-        detail::GetModuleInfo(*process_, patterns_info_full_pair.first);
-      auto const base =
-        reinterpret_cast<std::uintptr_t>(mod_info.module->GetHandle());
-      auto const& module = patterns_info_full_pair.first;
-      auto const& patterns_info_full = patterns_info_full_pair.second;
-      auto const& pattern_infos = patterns_info_full.patterns;
-      for (auto const& p : pattern_infos)
+      PeFile const pe_file{*process_,
+                           reinterpret_cast<void*>(base),
+                           hadesmem::PeFileType::Image,
+                           0};
+      NtHeaders const nt_headers{*process_, pe_file};
+      module_id.time_date_stamp = nt_headers.GetTimeDateStamp();
+      module_id.check_sum = nt_headers.GetCheckSum();
+      module_id.size_of_image = nt_headers.GetSizeOfImage();
+    }
+
+    for (std::size_t wave = 0; wave < num_waves; ++wave)
+    {
+      std::vector<detail::FindBatchRequest> requests;
+      std::vector<std::size_t> ids;
+      for (std::size_t i = 0; i < pattern_infos.size(); ++i)
       {
-        std::uint32_t const flags = patterns_info_full.flags | p.pattern.flags;
-        void* address = nullptr;
+        if (waves[i] != wave)
+        {
+          continue;
+        }
+
+        auto const& p = pattern_infos[i];
+        std::uint32_t const flags =
+          patterns_info_full.flags | p.pattern.flags;
         std::uintptr_t const start_rva = [&]() -> std::uintptr_t
         {
           if (!p.pattern.start_rva.empty())
@@ -1165,27 +2199,86 @@ private:
             return GetStartRvaFromExport(*mod_info.module,
                                          p.pattern.start_export);
           }
+          else if (!p.pattern.start.empty())
+          {
+            return GetStartRvaFromPattern(base, patterns[deps[i]]);
+          }
           else
           {
-            return GetStartRvaFromPattern(module, base, p.pattern.start);
+            return 0U;
           }
         }();
 
-        address = ::hadesmem::Find(
-          *process_, module, p.pattern.data, flags, start_rva, &p.pattern.name);
-
-        if (address)
+        if (cache)
         {
-          address = ApplyManipulators(address, flags, base, p.manipulators);
+          cache_keys[i] = GetPatternCacheKey(flags, p, start_rva);
+          if (auto const entry =
+                cache->Lookup(module_name, module_id, cache_keys[i]))
+          {
+            std::uintptr_t const value =
+              static_cast<std::uintptr_t>(entry->value);
+            void* address = nullptr;
+            if (entry->matched)
+            {
+              address = reinterpret_cast<void*>(
+                !!(flags & PatternFlags::kRelativeAddress) ? value
+                                                           : value + base);
+              address =
+                ApplyManipulators(address, flags, base, p.manipulators);
+            }
+
+            patterns[i] = Pattern{address, flags};
+            continue;
+          }
         }
 
-        find_pattern_datas_[patterns_info_full_pair.first][p.pattern.name] =
-          Pattern{address, flags};
+        void* const start_abs =
+          start_rva ? reinterpret_cast<std::uint8_t*>(base) + start_rva
+                    : nullptr;
+        requests.emplace_back(detail::FindBatchRequest{
+          &p.pattern.compiled, flags, start_abs, &p.pattern.name});
+        ids.push_back(i);
       }
+
+      auto const addresses =
+        detail::FindBatch(mod_info, region_cache, requests);
+      for (std::size_t j = 0; j < ids.size(); ++j)
+      {
+        auto const& p = pattern_infos[ids[j]];
+        std::uint32_t const flags = requests[j].flags;
+        void* const match = addresses[j];
+        void* const address =
+          match ? ApplyManipulators(match, flags, base, p.manipulators)
+                : nullptr;
+        patterns[ids[j]] = Pattern{address, flags};
+
+        if (cache)
+        {
+          std::uintptr_t const value =
+            !!(flags & PatternFlags::kRelativeAddress)
+              ? reinterpret_cast<std::uintptr_t>(match)
+              : reinterpret_cast<std::uintptr_t>(match) - base;
+          cache->Insert(module_name,
+                        module_id,
+                        cache_keys[ids[j]],
+                        detail::PatternCache::Entry{value, !!match});
+        }
+      }
+    }
+
+    for (std::size_t i = 0; i < pattern_infos.size(); ++i)
+    {
+      find_pattern_datas_[module_name]
+                         [pattern_infos[i].pattern.name] = patterns[i];
     }
   }
 
   Process const* process_;
-  ModuleMap find_pattern_datas_;
+  std::shared_ptr<detail::PatternCache> cache_;
+  std::wstring cache_path_;
+  mutable std::map<std::wstring, FindPatternInfo> pending_modules_;
+  mutable ModuleMap find_pattern_datas_;
+  // Guards lazy resolution. Shared so that the object stays copyable.
+  std::shared_ptr<std::mutex> mutex_;
 };
 }
@@ -8,7 +8,9 @@
 #include <windows.h>
 
 #include <hadesmem/detail/find_procedure.hpp>
+#include <hadesmem/error.hpp>
 #include <hadesmem/module.hpp>
+#include <hadesmem/procedure_resolver.hpp>
 #include <hadesmem/process.hpp>
 
 namespace hadesmem
@@ -41,4 +43,34 @@ inline FARPROC
 
   return remote_func;
 }
+
+// Same as the overloads above, but reuses the export tables already read by
+// resolver (which must be for the same process as module).
+inline FARPROC FindProcedure(ProcedureResolver& resolver,
+                             Module const& module,
+                             std::string const& name)
+{
+  FARPROC const remote_func = resolver.Find(module.GetHandle(), name);
+  if (!remote_func)
+  {
+    HADESMEM_DETAIL_THROW_EXCEPTION(
+      Error{} << ErrorString{"ProcedureResolver::Find failed."});
+  }
+
+  return remote_func;
+}
+
+inline FARPROC FindProcedure(ProcedureResolver& resolver,
+                             Module const& module,
+                             WORD ordinal)
+{
+  FARPROC const remote_func = resolver.Find(module.GetHandle(), ordinal);
+  if (!remote_func)
+  {
+    HADESMEM_DETAIL_THROW_EXCEPTION(
+      Error{} << ErrorString{"ProcedureResolver::Find failed."});
+  }
+
+  return remote_func;
+}
 }
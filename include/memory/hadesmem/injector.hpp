@@ -28,6 +28,7 @@
 #include <hadesmem/error.hpp>
 #include <hadesmem/find_procedure.hpp>
 #include <hadesmem/module.hpp>
+#include <hadesmem/procedure_resolver.hpp>
 #include <hadesmem/process.hpp>
 #include <hadesmem/write.hpp>
 
@@ -95,9 +96,12 @@ struct InjectFlags
   };
 };
 
+// resolver must be for process. Reusing one across calls (e.g. for CallExport
+// afterwards) saves reading the export tables of kernel32 again.
 inline HMODULE InjectDll(Process const& process,
                          std::wstring const& path,
-                         std::uint32_t flags)
+                         std::uint32_t flags,
+                         ProcedureResolver& resolver)
 {
   HADESMEM_DETAIL_ASSERT(!(flags & ~(InjectFlags::kInvalidFlagMaxValue - 1UL)));
 
@@ -152,7 +156,7 @@ inline HMODULE InjectDll(Process const& process,
 
   Module const kernel32_mod{process, L"kernel32.dll"};
   auto const load_library =
-    FindProcedure(process, kernel32_mod, "LoadLibraryExW");
+    FindProcedure(resolver, kernel32_mod, "LoadLibraryExW");
 
   HADESMEM_DETAIL_TRACE_A("Calling LoadLibraryExW.");
 
@@ -173,10 +177,20 @@ inline HMODULE InjectDll(Process const& process,
   return load_library_ret.GetReturnValue();
 }
 
-inline void FreeDll(Process const& process, HMODULE module)
+inline HMODULE InjectDll(Process const& process,
+                         std::wstring const& path,
+                         std::uint32_t flags)
+{
+  ProcedureResolver resolver{process};
+  return InjectDll(process, path, flags, resolver);
+}
+
+inline void
+  FreeDll(Process const& process, HMODULE module, ProcedureResolver& resolver)
 {
   Module const kernel32_mod{process, L"kernel32.dll"};
-  auto const free_library = FindProcedure(process, kernel32_mod, "FreeLibrary");
+  auto const free_library =
+    FindProcedure(resolver, kernel32_mod, "FreeLibrary");
 
   auto const free_library_ret =
     Call(process,
@@ -191,17 +205,32 @@ inline void FreeDll(Process const& process, HMODULE module)
   }
 }
 
+inline void FreeDll(Process const& process, HMODULE module)
+{
+  ProcedureResolver resolver{process};
+  FreeDll(process, module, resolver);
+}
+
 inline CallResult<DWORD_PTR> CallExport(Process const& process,
                                         HMODULE module,
-                                        std::string const& export_name)
+                                        std::string const& export_name,
+                                        ProcedureResolver& resolver)
 {
   Module const module_remote{process, module};
-  auto const export_ptr = FindProcedure(process, module_remote, export_name);
+  auto const export_ptr = FindProcedure(resolver, module_remote, export_name);
 
   return Call(
     process, reinterpret_cast<DWORD_PTR (*)()>(export_ptr), CallConv::kDefault);
 }
 
+inline CallResult<DWORD_PTR> CallExport(Process const& process,
+                                        HMODULE module,
+                                        std::string const& export_name)
+{
+  ProcedureResolver resolver{process};
+  return CallExport(process, module, export_name, resolver);
+}
+
 class CreateAndInjectData
 {
 public:
@@ -382,14 +411,15 @@ inline CreateAndInjectData CreateAndInject(std::wstring const& path,
   try
   {
     Process const process{proc_info.dwProcessId};
+    ProcedureResolver resolver{process};
 
-    HMODULE const remote_module = InjectDll(process, module, flags);
+    HMODULE const remote_module = InjectDll(process, module, flags, resolver);
 
     CallResult<DWORD_PTR> const export_ret = [&]()
     {
       if (!export_name.empty())
       {
-        return CallExport(process, remote_module, export_name);
+        return CallExport(process, remote_module, export_name, resolver);
       }
 
       return CallResult<DWORD_PTR>(0, 0);
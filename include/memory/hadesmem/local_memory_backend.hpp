@@ -0,0 +1,122 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+#include <windows.h>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/memory_backend.hpp>
+
+namespace hadesmem
+{
+namespace detail
+{
+struct CopyMemoryFault
+{
+  DWORD code;
+  PVOID address;
+};
+
+// Only records the fault, as calling into the system from an exception
+// filter isn't safe.
+inline int CopyMemoryFilter(EXCEPTION_POINTERS* exception_pointers,
+                            CopyMemoryFault& fault) HADESMEM_DETAIL_NOEXCEPT
+{
+  EXCEPTION_RECORD const& record = *exception_pointers->ExceptionRecord;
+  fault.code = record.ExceptionCode;
+  fault.address = record.NumberParameters >= 2
+                    ? reinterpret_cast<PVOID>(record.ExceptionInformation[1])
+                    : nullptr;
+  return (fault.code == EXCEPTION_ACCESS_VIOLATION ||
+          fault.code == EXCEPTION_IN_PAGE_ERROR ||
+          fault.code == STATUS_GUARD_PAGE_VIOLATION)
+           ? EXCEPTION_EXECUTE_HANDLER
+           : EXCEPTION_CONTINUE_SEARCH;
+}
+
+// Plain memcpy which returns false instead of crashing if either side faults.
+// Must not contain any objects with destructors (SEH and C++ unwinding can't
+// be mixed in the same function).
+inline bool CopyMemoryGuarded(void* dst, void const* src, std::size_t len)
+  HADESMEM_DETAIL_NOEXCEPT
+{
+  CopyMemoryFault fault = {0, nullptr};
+  __try
+  {
+    std::memcpy(dst, src, len);
+    return true;
+  }
+  __except (CopyMemoryFilter(GetExceptionInformation(), fault))
+  {
+  }
+
+  // Touching the page cleared its guard, so put it back. The access then
+  // fails just like ReadProcessMemory would.
+  if (fault.code == STATUS_GUARD_PAGE_VIOLATION && fault.address)
+  {
+    MEMORY_BASIC_INFORMATION mbi{};
+    DWORD old_protect = 0;
+    if (::VirtualQuery(fault.address, &mbi, sizeof(mbi)) == sizeof(mbi))
+    {
+      ::VirtualProtect(
+        fault.address, 1, mbi.Protect | PAGE_GUARD, &old_protect);
+    }
+  }
+
+  return false;
+}
+}
+
+// Accesses the memory of the current process directly, without going through
+// a process handle. Faults are caught with structured exception handling, so
+// a bad address fails the access (with ERROR_NOACCESS) rather than crashing.
+// This is the default backend for a Process referring to the current
+// process.
+class LocalMemoryBackend : public MemoryBackend
+{
+public:
+  virtual bool Read(LPCVOID address, LPVOID data, std::size_t len) override
+  {
+    if (!detail::CopyMemoryGuarded(data, address, len))
+    {
+      ::SetLastError(ERROR_NOACCESS);
+      return false;
+    }
+
+    return true;
+  }
+
+  virtual bool Write(LPVOID address, LPCVOID data, std::size_t len) override
+  {
+    if (!detail::CopyMemoryGuarded(address, data, len))
+    {
+      ::SetLastError(ERROR_NOACCESS);
+      return false;
+    }
+
+    return true;
+  }
+
+  virtual bool Query(LPCVOID address, MEMORY_BASIC_INFORMATION& mbi) override
+  {
+    return ::VirtualQuery(address, &mbi, sizeof(mbi)) == sizeof(mbi);
+  }
+
+  virtual bool Protect(LPVOID address,
+                       SIZE_T size,
+                       DWORD protect,
+                       DWORD& old_protect) override
+  {
+    return !!::VirtualProtect(address, size, protect, &old_protect);
+  }
+
+  virtual bool IsDirect() const override
+  {
+    return true;
+  }
+};
+}
@@ -0,0 +1,49 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+
+#include <windows.h>
+
+#include <hadesmem/config.hpp>
+
+namespace hadesmem
+{
+// Source of the memory accessed through a Process. By default memory is
+// accessed with ReadProcessMemory, WriteProcessMemory, VirtualQueryEx and
+// VirtualProtectEx on the process handle. Once a backend is attached (see
+// Process::SetMemoryBackend) the read, write, query and protect primitives
+// (and therefore everything built on them, including the PE classes) use it
+// instead.
+// Each function returns false on failure, with the last error set in the
+// same way as the corresponding API. In particular Query must fail with
+// ERROR_INVALID_PARAMETER for addresses past the end of the address space so
+// region enumeration terminates. The functions must not throw, as they are
+// also used by the non-throwing Try* primitives.
+class MemoryBackend
+{
+public:
+  virtual ~MemoryBackend()
+  {
+  }
+
+  virtual bool Read(LPCVOID address, LPVOID data, std::size_t len) = 0;
+
+  virtual bool Write(LPVOID address, LPCVOID data, std::size_t len) = 0;
+
+  virtual bool Query(LPCVOID address, MEMORY_BASIC_INFORMATION& mbi) = 0;
+
+  virtual bool
+    Protect(LPVOID address, SIZE_T size, DWORD protect, DWORD& old_protect) = 0;
+
+  // Direct backends make accesses cheap enough (and failures harmless enough)
+  // that Read and Write attempt them straight away, and only query and change
+  // protection if that fails.
+  virtual bool IsDirect() const
+  {
+    return false;
+  }
+};
+}
@@ -0,0 +1,178 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#include <windows.h>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/read_impl.hpp>
+#include <hadesmem/detail/snapshot_diff.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/region.hpp>
+#include <hadesmem/region_list.hpp>
+
+namespace hadesmem
+{
+// A run of bytes which changed between two polls. The data pointers are only
+// valid for the duration of the callback.
+struct MemoryChange
+{
+  PVOID address;
+  std::uint8_t const* old_data;
+  std::uint8_t const* new_data;
+  std::size_t size;
+};
+
+// Watches a set of ranges for changes by reading each of them in full every
+// poll and diffing the result against the previous poll (see
+// detail::DiffSnapshots). A range which can't be read is skipped for that
+// poll, and changes are only reported between two successful reads. The
+// first poll only takes the initial snapshot.
+class MemoryWatcher
+{
+public:
+  explicit MemoryWatcher(
+    Process const& process,
+    std::chrono::milliseconds interval = std::chrono::milliseconds(100),
+    std::size_t merge_gap = 0)
+    : process_{&process}, interval_(interval), merge_gap_{merge_gap}
+  {
+  }
+
+  explicit MemoryWatcher(
+    Process&& process,
+    std::chrono::milliseconds interval = std::chrono::milliseconds(100),
+    std::size_t merge_gap = 0) = delete;
+
+  void AddRange(PVOID address, std::size_t size)
+  {
+    HADESMEM_DETAIL_ASSERT(size ? address != nullptr : true);
+
+    snapshots_.AddRange(reinterpret_cast<std::uintptr_t>(address), size);
+  }
+
+  // Adds every committed region for which pred(region) returns true, e.g.
+  // all writable private memory. Returns the number of regions added.
+  template <typename Pred> std::size_t AddRegions(Pred pred)
+  {
+    std::size_t num_added = 0;
+    RegionList const regions(*process_);
+    for (auto const& region : regions)
+    {
+      if (region.GetState() == MEM_COMMIT && pred(region))
+      {
+        AddRange(region.GetBase(), region.GetSize());
+        ++num_added;
+      }
+    }
+
+    return num_added;
+  }
+
+  // Reads every range and calls func(change) for each change since the last
+  // poll. Returns the number of changes.
+  template <typename Func> std::size_t Poll(Func func)
+  {
+    for (std::size_t i = 0; i < snapshots_.GetNumRanges(); ++i)
+    {
+      snapshots_.SetCurrentValid(i, ReadRange(i));
+    }
+
+    std::size_t const num_changes = snapshots_.Diff(
+      merge_gap_,
+      [&](std::uintptr_t address,
+          std::uint8_t const* old_data,
+          std::uint8_t const* new_data,
+          std::size_t size)
+      {
+        MemoryChange const change = {
+          reinterpret_cast<PVOID>(address), old_data, new_data, size};
+        func(change);
+      });
+    snapshots_.Advance();
+
+    return num_changes;
+  }
+
+  // Polls at the configured interval until stop is set. If a poll takes
+  // longer than the interval the next one starts immediately.
+  template <typename Func> void Run(Func func, std::atomic<bool> const& stop)
+  {
+    auto next = std::chrono::steady_clock::now();
+    while (!stop)
+    {
+      Poll(func);
+      next += interval_;
+      auto const now = std::chrono::steady_clock::now();
+      if (next < now)
+      {
+        next = now;
+      }
+      else
+      {
+        std::this_thread::sleep_until(next);
+      }
+    }
+  }
+
+  std::size_t GetNumRanges() const
+  {
+    return snapshots_.GetNumRanges();
+  }
+
+  std::chrono::milliseconds GetInterval() const
+  {
+    return interval_;
+  }
+
+  void SetInterval(std::chrono::milliseconds interval)
+  {
+    interval_ = interval;
+  }
+
+  void Clear()
+  {
+    snapshots_.Clear();
+  }
+
+private:
+  bool ReadRange(std::size_t index)
+  {
+    std::size_t const size = snapshots_.GetSize(index);
+    if (!size)
+    {
+      return true;
+    }
+
+    // Bypass the memory cache of the process (if any), which would hide the
+    // very changes being watched for.
+    try
+    {
+      detail::ReadUncachedImpl(
+        *process_,
+        reinterpret_cast<PVOID>(snapshots_.GetAddress(index)),
+        snapshots_.GetCurrent(index),
+        size);
+      return true;
+    }
+    catch (Error const&)
+    {
+      return false;
+    }
+  }
+
+  Process const* process_;
+  std::chrono::milliseconds interval_;
+  std::size_t merge_gap_;
+  detail::SnapshotStore snapshots_;
+};
+}
@@ -27,7 +27,9 @@ class DosHeader
 {
 public:
   explicit DosHeader(Process const& process, PeFile const& pe_file)
-    : process_{&process}, base_{static_cast<std::uint8_t*>(pe_file.GetBase())}
+    : process_{&process},
+      pe_file_{&pe_file},
+      base_{static_cast<std::uint8_t*>(pe_file.GetBase())}
   {
     UpdateRead();
 
@@ -67,6 +69,7 @@ public:
   void UpdateWrite()
   {
     Write(*process_, base_, data_);
+    pe_file_->InvalidateHeaders();
   }
 
   WORD GetMagic() const
@@ -270,6 +273,7 @@ public:
 
 private:
   Process const* process_;
+  PeFile const* pe_file_;
   PBYTE base_;
   IMAGE_DOS_HEADER data_ = IMAGE_DOS_HEADER{};
 };
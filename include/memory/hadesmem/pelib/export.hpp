@@ -3,14 +3,18 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <iosfwd>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <windows.h>
 #include <winnt.h>
@@ -27,95 +31,167 @@
 
 namespace hadesmem
 {
-class Export
+namespace detail
 {
-public:
-  explicit Export(Process const& process,
-                  PeFile const& pe_file,
-                  WORD procedure_number)
-    : process_{&process},
-      pe_file_{&pe_file},
-      procedure_number_{procedure_number}
+DWORD const kNoExportName = (std::numeric_limits<DWORD>::max)();
+
+// The tables referenced by the export directory, read in bulk so that
+// enumerating every export doesn't have to re-read them per export.
+struct ExportTables
+{
+  DWORD ordinal_base;
+  DWORD export_dir_start;
+  DWORD export_dir_end;
+  // NumberOfFunctions, clamped to the number of ordinals which can be
+  // represented by a procedure number.
+  DWORD num_functions;
+  // AddressOfFunctions, indexed by ordinal number. Only covers the part of
+  // the table which lies within the image and is readable, so it may be
+  // shorter than num_functions. Empty if the table is invalid.
+  std::vector<DWORD> functions;
+  // AddressOfNames and AddressOfNameOrdinals.
+  std::vector<DWORD> name_rvas;
+  std::vector<WORD> name_ordinals;
+  // For each ordinal number the index in name_rvas of the first name which
+  // refers to it, or kNoExportName. Empty if there are no names.
+  std::vector<DWORD> name_indices;
+};
+
+// Number of function table entries read at a time if the table can't be read
+// in one go.
+std::size_t const kExportTableChunkSize = 0x400;
+
+// Reads up to count entries from ptr, stopping at end. If the whole range
+// can't be read only its readable prefix is returned.
+inline std::vector<DWORD> ReadExportFunctions(Process const& process,
+                                              DWORD* ptr,
+                                              std::uint8_t* end,
+                                              DWORD count)
+{
+  auto const cur = reinterpret_cast<std::uint8_t*>(ptr);
+  if (cur >= end)
   {
-    ExportDir const export_dir{process, pe_file};
+    return {};
+  }
 
-    auto const ordinal_base = static_cast<WORD>(export_dir.GetOrdinalBase());
-    HADESMEM_DETAIL_ASSERT(procedure_number_ >= ordinal_base);
-    ordinal_number_ = static_cast<WORD>(procedure_number_ - ordinal_base);
-    if (ordinal_number_ >= export_dir.GetNumberOfFunctions())
+  count = static_cast<DWORD>((std::min)(
+    static_cast<std::size_t>(count),
+    static_cast<std::size_t>(end - cur) / sizeof(DWORD)));
+
+  try
+  {
+    return ReadVector<DWORD>(process, ptr, count);
+  }
+  catch (Error const&)
+  {
+  }
+
+  std::vector<DWORD> functions;
+  while (functions.size() < count)
+  {
+    std::size_t const chunk_size =
+      (std::min)(kExportTableChunkSize, count - functions.size());
+    try
     {
-      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
-                                      << ErrorString{"Ordinal out of range."});
+      std::vector<DWORD> const chunk =
+        ReadVector<DWORD>(process, ptr + functions.size(), chunk_size);
+      functions.insert(std::end(functions), std::begin(chunk), std::end(chunk));
     }
-
-    if (DWORD const num_names = export_dir.GetNumberOfNames())
+    catch (Error const&)
     {
-      WORD* const ptr_ordinals = static_cast<WORD*>(
-        RvaToVa(process, pe_file, export_dir.GetAddressOfNameOrdinals()));
-      DWORD* const ptr_names = static_cast<DWORD*>(
-        RvaToVa(process, pe_file, export_dir.GetAddressOfNames()));
+      break;
+    }
+  }
+
+  return functions;
+}
+
+inline ExportTables ReadExportTables(Process const& process,
+                                     PeFile const& pe_file)
+{
+  ExportDir const export_dir{process, pe_file};
+  NtHeaders const nt_headers{process, pe_file};
+
+  ExportTables tables;
+  tables.ordinal_base = export_dir.GetOrdinalBase();
+  tables.export_dir_start =
+    nt_headers.GetDataDirectoryVirtualAddress(PeDataDir::Export);
+  tables.export_dir_end = tables.export_dir_start +
+                          nt_headers.GetDataDirectorySize(PeDataDir::Export);
+  tables.num_functions = (std::min)(
+    export_dir.GetNumberOfFunctions(),
+    static_cast<DWORD>((std::numeric_limits<WORD>::max)()) + 1);
+
+  if (!tables.num_functions)
+  {
+    return tables;
+  }
 
-      if (ptr_ordinals && ptr_names)
+  if (DWORD const num_names = export_dir.GetNumberOfNames())
+  {
+    WORD* const ptr_ordinals = static_cast<WORD*>(
+      RvaToVa(process, pe_file, export_dir.GetAddressOfNameOrdinals()));
+    DWORD* const ptr_names = static_cast<DWORD*>(
+      RvaToVa(process, pe_file, export_dir.GetAddressOfNames()));
+
+    if (ptr_ordinals && ptr_names)
+    {
+      tables.name_ordinals =
+        ReadVector<WORD>(process, ptr_ordinals, num_names);
+      tables.name_rvas = ReadVector<DWORD>(process, ptr_names, num_names);
+      tables.name_indices.assign(tables.num_functions, kNoExportName);
+      for (DWORD i = 0; i < num_names; ++i)
       {
-        std::vector<WORD> const name_ordinals =
-          ReadVector<WORD>(process, ptr_ordinals, num_names);
-        auto const name_ord_iter = std::find(
-          std::begin(name_ordinals), std::end(name_ordinals), ordinal_number_);
-        if (name_ord_iter != std::end(name_ordinals))
+        WORD const ordinal_number = tables.name_ordinals[i];
+        if (ordinal_number < tables.num_functions &&
+            tables.name_indices[ordinal_number] == kNoExportName)
         {
-          by_name_ = true;
-          DWORD const name_rva =
-            Read<DWORD>(process,
-                        ptr_names + std::distance(std::begin(name_ordinals),
-                                                  name_ord_iter));
-          name_ = detail::CheckedReadString<char>(
-            process, pe_file, RvaToVa(process, pe_file, name_rva));
+          tables.name_indices[ordinal_number] = i;
         }
       }
     }
+  }
 
-    DWORD* const ptr_functions = static_cast<DWORD*>(
-      RvaToVa(process, pe_file, export_dir.GetAddressOfFunctions()));
-    if (!ptr_functions)
-    {
-      HADESMEM_DETAIL_THROW_EXCEPTION(
-        Error{} << ErrorString{"AddressOfFunctions invalid."});
-    }
-    DWORD const func_rva =
-      Read<DWORD>(process, ptr_functions + ordinal_number_);
-
-    NtHeaders const nt_headers{process, pe_file};
+  if (DWORD* const ptr_functions = static_cast<DWORD*>(
+        RvaToVa(process, pe_file, export_dir.GetAddressOfFunctions())))
+  {
+    auto const base = static_cast<std::uint8_t*>(pe_file.GetBase());
+    std::uint8_t* const end =
+      base + (pe_file.GetType() == PeFileType::Data
+                ? pe_file.GetSize()
+                : nt_headers.GetSizeOfImage());
+    tables.functions = ReadExportFunctions(
+      process, ptr_functions, end, tables.num_functions);
+  }
 
-    DWORD const export_dir_start =
-      nt_headers.GetDataDirectoryVirtualAddress(PeDataDir::Export);
-    DWORD const export_dir_end =
-      export_dir_start + nt_headers.GetDataDirectorySize(PeDataDir::Export);
+  return tables;
+}
+}
 
-    // Check function RVA. If it lies inside the export dir region
-    // then it's a forwarded export. Otherwise it's a regular RVA.
-    if (func_rva > export_dir_start && func_rva < export_dir_end)
-    {
-      forwarded_ = true;
-      forwarder_ = detail::CheckedReadString<char>(
-        process, pe_file, RvaToVa(process, pe_file, func_rva));
+class Export
+{
+public:
+  explicit Export(Process const& process,
+                  PeFile const& pe_file,
+                  WORD procedure_number)
+    : process_{&process},
+      pe_file_{&pe_file},
+      procedure_number_{procedure_number}
+  {
+    Initialize(detail::ReadExportTables(process, pe_file));
+  }
 
-      std::string::size_type const split_pos = forwarder_.rfind('.');
-      if (split_pos != std::string::npos)
-      {
-        forwarder_split_ = std::make_pair(forwarder_.substr(0, split_pos),
-                                          forwarder_.substr(split_pos + 1));
-      }
-      else
-      {
-        HADESMEM_DETAIL_THROW_EXCEPTION(
-          Error{} << ErrorString{"Invalid forwarder string format."});
-      }
-    }
-    else
-    {
-      rva_ = func_rva;
-      va_ = RvaToVa(process, pe_file, func_rva);
-    }
+  // Avoids re-reading the export tables when constructing many exports from
+  // the same module (e.g. in ExportList).
+  explicit Export(Process const& process,
+                  PeFile const& pe_file,
+                  detail::ExportTables const& tables,
+                  WORD procedure_number)
+    : process_{&process},
+      pe_file_{&pe_file},
+      procedure_number_{procedure_number}
+  {
+    Initialize(tables);
   }
 
   explicit Export(Process&& process,
@@ -130,6 +206,21 @@ public:
                   PeFile&& pe_file,
                   WORD procedure_number) = delete;
 
+  explicit Export(Process&& process,
+                  PeFile const& pe_file,
+                  detail::ExportTables const& tables,
+                  WORD procedure_number) = delete;
+
+  explicit Export(Process const& process,
+                  PeFile&& pe_file,
+                  detail::ExportTables const& tables,
+                  WORD procedure_number) = delete;
+
+  explicit Export(Process&& process,
+                  PeFile&& pe_file,
+                  detail::ExportTables const& tables,
+                  WORD procedure_number) = delete;
+
 #if defined(HADESMEM_DETAIL_NO_RVALUE_REFERENCES_V3)
 
   Export(Export const&) = default;
@@ -251,6 +342,64 @@ public:
   }
 
 private:
+  void Initialize(detail::ExportTables const& tables)
+  {
+    auto const ordinal_base = static_cast<WORD>(tables.ordinal_base);
+    HADESMEM_DETAIL_ASSERT(procedure_number_ >= ordinal_base);
+    ordinal_number_ = static_cast<WORD>(procedure_number_ - ordinal_base);
+    if (ordinal_number_ >= tables.num_functions)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Ordinal out of range."});
+    }
+
+    if (!tables.name_indices.empty())
+    {
+      DWORD const name_index = tables.name_indices[ordinal_number_];
+      if (name_index != detail::kNoExportName)
+      {
+        by_name_ = true;
+        name_ = detail::CheckedReadString<char>(
+          *process_,
+          *pe_file_,
+          RvaToVa(*process_, *pe_file_, tables.name_rvas[name_index]));
+      }
+    }
+
+    if (ordinal_number_ >= tables.functions.size())
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"AddressOfFunctions invalid."});
+    }
+    DWORD const func_rva = tables.functions[ordinal_number_];
+
+    // Check function RVA. If it lies inside the export dir region
+    // then it's a forwarded export. Otherwise it's a regular RVA.
+    if (func_rva > tables.export_dir_start && func_rva < tables.export_dir_end)
+    {
+      forwarded_ = true;
+      forwarder_ = detail::CheckedReadString<char>(
+        *process_, *pe_file_, RvaToVa(*process_, *pe_file_, func_rva));
+
+      std::string::size_type const split_pos = forwarder_.rfind('.');
+      if (split_pos != std::string::npos)
+      {
+        forwarder_split_ = std::make_pair(forwarder_.substr(0, split_pos),
+                                          forwarder_.substr(split_pos + 1));
+      }
+      else
+      {
+        HADESMEM_DETAIL_THROW_EXCEPTION(
+          Error{} << ErrorString{"Invalid forwarder string format."});
+      }
+    }
+    else
+    {
+      rva_ = func_rva;
+      va_ = RvaToVa(*process_, *pe_file_, func_rva);
+    }
+  }
+
   Process const* process_;
   PeFile const* pe_file_;
   DWORD rva_{};
@@ -0,0 +1,194 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <windows.h>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/pelib/export.hpp>
+#include <hadesmem/pelib/pe_file.hpp>
+#include <hadesmem/process.hpp>
+
+namespace hadesmem
+{
+// Lookup index over a module's exports, built from a single read of the
+// export tables. Lookups by ordinal index the function table directly, and
+// lookups by name binary search the name pointer table (which the PE format
+// requires to be sorted, and which the loader searches the same way), so
+// only O(log n) names are read per lookup. Callers doing many lookups can
+// call BuildNameMap to read every name once and use a hash map instead.
+class ExportIndex
+{
+public:
+  explicit ExportIndex(Process const& process, PeFile const& pe_file)
+    : process_{&process},
+      pe_file_{&pe_file},
+      tables_(detail::ReadExportTables(process, pe_file))
+  {
+  }
+
+  explicit ExportIndex(Process&& process, PeFile const& pe_file) = delete;
+
+  explicit ExportIndex(Process const& process, PeFile&& pe_file) = delete;
+
+  explicit ExportIndex(Process&& process, PeFile&& pe_file) = delete;
+
+  // Returns false if no export has the given name.
+  bool FindProcedureNumber(std::string const& name,
+                           WORD& procedure_number) const
+  {
+    DWORD name_index = detail::kNoExportName;
+    if (HasNameMap())
+    {
+      auto const iter = name_map_.find(name);
+      if (iter != std::end(name_map_))
+      {
+        name_index = iter->second;
+      }
+    }
+    else
+    {
+      name_index = SearchName(name);
+    }
+
+    if (name_index == detail::kNoExportName)
+    {
+      return false;
+    }
+
+    WORD const ordinal_number = tables_.name_ordinals[name_index];
+    if (ordinal_number >= tables_.num_functions)
+    {
+      return false;
+    }
+
+    procedure_number =
+      static_cast<WORD>(ordinal_number + GetOrdinalBaseClamped());
+    return true;
+  }
+
+  // Returns whether the procedure number refers to a used entry in the
+  // function table.
+  bool HasProcedure(WORD procedure_number) const HADESMEM_DETAIL_NOEXCEPT
+  {
+    WORD const ordinal_base = GetOrdinalBaseClamped();
+    if (procedure_number < ordinal_base)
+    {
+      return false;
+    }
+
+    WORD const ordinal_number =
+      static_cast<WORD>(procedure_number - ordinal_base);
+    return ordinal_number < tables_.functions.size() &&
+           tables_.functions[ordinal_number] != 0;
+  }
+
+  Export GetExport(WORD procedure_number) const
+  {
+    if (!HasProcedure(procedure_number))
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Invalid export number."});
+    }
+
+    return Export{*process_, *pe_file_, tables_, procedure_number};
+  }
+
+  void BuildNameMap()
+  {
+    if (HasNameMap())
+    {
+      return;
+    }
+
+    std::unordered_map<std::string, DWORD> name_map;
+    name_map.reserve(tables_.name_rvas.size());
+    for (std::size_t i = 0; i < tables_.name_rvas.size(); ++i)
+    {
+      // Keep the first of any duplicates, as they can't all be found by the
+      // binary search either.
+      name_map.emplace(GetName(i), static_cast<DWORD>(i));
+    }
+
+    name_map_ = std::move(name_map);
+    has_name_map_ = true;
+  }
+
+  bool HasNameMap() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return has_name_map_;
+  }
+
+  DWORD GetOrdinalBase() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return tables_.ordinal_base;
+  }
+
+  DWORD GetNumberOfFunctions() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return tables_.num_functions;
+  }
+
+  std::size_t GetNumberOfNames() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return tables_.name_rvas.size();
+  }
+
+private:
+  // Procedure numbers are WORDs, so only the low word of the base is used
+  // (as in Export).
+  WORD GetOrdinalBaseClamped() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return static_cast<WORD>(tables_.ordinal_base);
+  }
+
+  std::string GetName(std::size_t name_index) const
+  {
+    HADESMEM_DETAIL_ASSERT(name_index < tables_.name_rvas.size());
+    return detail::CheckedReadString<char>(
+      *process_,
+      *pe_file_,
+      RvaToVa(*process_, *pe_file_, tables_.name_rvas[name_index]));
+  }
+
+  DWORD SearchName(std::string const& name) const
+  {
+    std::size_t beg = 0;
+    std::size_t end = tables_.name_rvas.size();
+    while (beg < end)
+    {
+      std::size_t const mid = beg + (end - beg) / 2;
+      int const cmp = name.compare(GetName(mid));
+      if (cmp == 0)
+      {
+        return static_cast<DWORD>(mid);
+      }
+
+      if (cmp < 0)
+      {
+        end = mid;
+      }
+      else
+      {
+        beg = mid + 1;
+      }
+    }
+
+    return detail::kNoExportName;
+  }
+
+  Process const* process_;
+  PeFile const* pe_file_;
+  detail::ExportTables tables_;
+  std::unordered_map<std::string, DWORD> name_map_;
+  bool has_name_map_{};
+};
+}
@@ -42,10 +42,13 @@ public:
   {
     try
     {
-      ExportDir const export_dir{process, pe_file};
-      Export const exp{
-        process, pe_file, static_cast<WORD>(export_dir.GetOrdinalBase())};
-      impl_ = std::make_shared<Impl>(process, pe_file, exp);
+      auto impl = std::make_shared<Impl>(
+        process, pe_file, detail::ReadExportTables(process, pe_file));
+      impl->export_ = Export{process,
+                             pe_file,
+                             impl->tables_,
+                             static_cast<WORD>(impl->tables_.ordinal_base)};
+      impl_ = impl;
     }
     catch (std::exception const& /*e*/)
     {
@@ -97,25 +100,16 @@ public:
     {
       HADESMEM_DETAIL_ASSERT(impl_.get());
 
-      ExportDir const export_dir{*impl_->process_, *impl_->pe_file_};
+      detail::ExportTables const& tables = impl_->tables_;
 
-      DWORD* ptr_functions =
-        static_cast<DWORD*>(RvaToVa(*impl_->process_,
-                                    *impl_->pe_file_,
-                                    export_dir.GetAddressOfFunctions()));
+      DWORD const ordinal_base = tables.ordinal_base;
 
-      DWORD const ordinal_base = export_dir.GetOrdinalBase();
+      DWORD ordinal_number = impl_->export_->GetOrdinalNumber() + 1UL;
 
-      WORD const procedure_number = impl_->export_->GetProcedureNumber();
-
-      WORD ordinal_number =
-        static_cast<WORD>((procedure_number - ordinal_base) + 1);
-
-      DWORD const num_funcs = export_dir.GetNumberOfFunctions();
+      DWORD const num_funcs = static_cast<DWORD>(tables.functions.size());
 
       for (; ((ordinal_number + ordinal_base) >= ordinal_base) &&
-               !Read<DWORD>(*impl_->process_, ptr_functions + ordinal_number) &&
-               ordinal_number < num_funcs;
+               ordinal_number < num_funcs && !tables.functions[ordinal_number];
            ++ordinal_number)
       {
       }
@@ -135,8 +129,8 @@ public:
       WORD const new_procedure_number =
         static_cast<WORD>(ordinal_number + ordinal_base);
 
-      impl_->export_ =
-        Export{*impl_->process_, *impl_->pe_file_, new_procedure_number};
+      impl_->export_ = Export{
+        *impl_->process_, *impl_->pe_file_, tables, new_procedure_number};
     }
     catch (std::exception const& /*e*/)
     {
@@ -168,15 +162,17 @@ private:
   {
     explicit Impl(Process const& process,
                   PeFile const& pe_file,
-                  Export const& exp) HADESMEM_DETAIL_NOEXCEPT
+                  detail::ExportTables&& tables) HADESMEM_DETAIL_NOEXCEPT
       : process_{&process},
         pe_file_{&pe_file},
-        export_(exp)
+        tables_(std::move(tables))
     {
     }
 
     Process const* process_;
     PeFile const* pe_file_;
+    // Read once up front and shared by every export produced.
+    detail::ExportTables tables_;
     hadesmem::detail::Optional<Export> export_;
   };
 
@@ -0,0 +1,654 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+#include <winnt.h>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/pelib/nt_headers.hpp>
+#include <hadesmem/pelib/pe_file.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/read.hpp>
+#include <hadesmem/read_batch.hpp>
+#include <hadesmem/write_transaction.hpp>
+
+namespace hadesmem
+{
+namespace detail
+{
+// Number of descriptors or thunks read at a time while looking for the
+// terminating entry.
+std::size_t const kImportTableChunkSize = 64;
+
+struct ImportTableString
+{
+  std::uint8_t* address;
+  // Bytes before the string which are kept with it (e.g. the hint of an
+  // IMAGE_IMPORT_BY_NAME).
+  std::size_t prefix_size;
+  // Offset of the prefix in the blob, with the NUL terminated string
+  // following it.
+  std::size_t offset;
+  bool valid;
+};
+
+// Reads all of the requested strings into blob. Strings close together (as
+// import names almost always are) are read in a single span, and only those
+// which can't be found in full in their span are read individually.
+inline void ReadImportTableStrings(Process const& process,
+                                   PeFile const& pe_file,
+                                   std::uint8_t* end,
+                                   std::vector<ImportTableString>& strings,
+                                   std::vector<char>& blob)
+{
+  std::vector<std::size_t> order(strings.size());
+  for (std::size_t i = 0; i < order.size(); ++i)
+  {
+    order[i] = i;
+  }
+  std::sort(std::begin(order),
+            std::end(order),
+            [&](std::size_t lhs, std::size_t rhs)
+            {
+    return strings[lhs].address < strings[rhs].address;
+  });
+
+  std::vector<char> buffer;
+  for (std::size_t i = 0; i < order.size();)
+  {
+    std::uint8_t* const span_beg = strings[order[i]].address;
+    std::size_t j = i + 1;
+    while (j < order.size() &&
+           static_cast<std::size_t>(strings[order[j]].address -
+                                    strings[order[j - 1]].address) <=
+             kReadBatchMaxGap &&
+           static_cast<std::size_t>(strings[order[j]].address - span_beg) <
+             kReadBatchMaxSpanSize)
+    {
+      ++j;
+    }
+
+    // Allow for the length of the last string.
+    std::uint8_t* const last = strings[order[j - 1]].address;
+    std::uint8_t* const span_end =
+      last < end && static_cast<std::size_t>(end - last) > kReadBatchMaxGap
+        ? last + kReadBatchMaxGap
+        : end;
+    buffer.clear();
+    if (span_beg < span_end)
+    {
+      try
+      {
+        buffer = ReadVector<char>(process, span_beg, span_end - span_beg);
+      }
+      catch (Error const&)
+      {
+        buffer.clear();
+      }
+    }
+
+    for (; i < j; ++i)
+    {
+      ImportTableString& str = strings[order[i]];
+      str.offset = blob.size();
+      str.valid = true;
+
+      std::size_t const pos =
+        static_cast<std::size_t>(str.address - span_beg) + str.prefix_size;
+      char const* const data = buffer.data();
+      char const* const nul =
+        pos < buffer.size()
+          ? static_cast<char const*>(
+              std::memchr(data + pos, '\0', buffer.size() - pos))
+          : nullptr;
+      if (nul)
+      {
+        blob.insert(std::end(blob), data + pos - str.prefix_size, nul + 1);
+        continue;
+      }
+
+      try
+      {
+        if (str.prefix_size)
+        {
+          std::vector<char> const prefix =
+            ReadVector<char>(process, str.address, str.prefix_size);
+          blob.insert(std::end(blob), std::begin(prefix), std::end(prefix));
+        }
+        std::string const name = CheckedReadString<char>(
+          process, pe_file, str.address + str.prefix_size);
+        blob.insert(
+          std::end(blob), name.c_str(), name.c_str() + name.size() + 1);
+      }
+      catch (Error const&)
+      {
+        blob.resize(str.offset);
+        str.valid = false;
+      }
+    }
+  }
+}
+
+// Reads entries of type T from ptr up to (but not including) the first one
+// for which is_terminator returns true, stopping early at end or at the
+// first unreadable chunk.
+template <typename T, typename Pred>
+std::vector<T> ReadImportTableArray(Process const& process,
+                                    std::uint8_t* ptr,
+                                    std::uint8_t* end,
+                                    Pred is_terminator)
+{
+  std::vector<T> entries;
+  while (ptr < end)
+  {
+    std::size_t const count = (std::min)(
+      kImportTableChunkSize, static_cast<std::size_t>(end - ptr) / sizeof(T));
+    if (!count)
+    {
+      break;
+    }
+
+    std::vector<T> chunk;
+    try
+    {
+      chunk = ReadVector<T>(process, ptr, count);
+    }
+    catch (Error const&)
+    {
+      break;
+    }
+
+    auto const term =
+      std::find_if(std::begin(chunk), std::end(chunk), is_terminator);
+    entries.insert(std::end(entries), std::begin(chunk), term);
+    if (term != std::end(chunk))
+    {
+      break;
+    }
+
+    ptr += count * sizeof(T);
+  }
+
+  return entries;
+}
+}
+
+class ImportTableThunk
+{
+public:
+  // Address of the entry in the import name table (or the import address
+  // table if there is no separate name table).
+  PVOID GetBase() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return base_;
+  }
+
+  // Address of the entry in the import address table, or nullptr if it is
+  // invalid.
+  PVOID GetIatBase() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return iat_base_;
+  }
+
+  DWORD_PTR GetAddressOfData() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return data_;
+  }
+
+  DWORD_PTR GetOrdinalRaw() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return data_;
+  }
+
+  bool ByOrdinal() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return IMAGE_SNAP_BY_ORDINAL(GetOrdinalRaw());
+  }
+
+  WORD GetOrdinal() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return IMAGE_ORDINAL(GetOrdinalRaw());
+  }
+
+  WORD GetHint() const
+  {
+    EnsureHasName();
+    WORD hint = 0;
+    std::memcpy(&hint, name_ - sizeof(hint), sizeof(hint));
+    return hint;
+  }
+
+  std::string GetName() const
+  {
+    EnsureHasName();
+    return name_;
+  }
+
+  // The value in the import address table when the snapshot was taken (or
+  // as set by SetFunction).
+  DWORD_PTR GetFunction() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return function_;
+  }
+
+  // Takes effect on the next ImportTable::UpdateWrite.
+  void SetFunction(DWORD_PTR function) HADESMEM_DETAIL_NOEXCEPT
+  {
+    function_ = function;
+    modified_ = true;
+  }
+
+private:
+  friend class ImportTable;
+
+  void EnsureHasName() const
+  {
+    if (ByOrdinal() || !name_)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Invalid import name and hint."});
+    }
+  }
+
+  PVOID base_{};
+  PVOID iat_base_{};
+  DWORD_PTR data_{};
+  DWORD_PTR function_{};
+  // Points into the name blob of the table, just after the hint.
+  char const* name_{};
+  bool modified_{};
+};
+
+class ImportTableDir
+{
+public:
+  PVOID GetBase() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return base_;
+  }
+
+  DWORD GetOriginalFirstThunk() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return data_.OriginalFirstThunk;
+  }
+
+  DWORD GetTimeDateStamp() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return data_.TimeDateStamp;
+  }
+
+  DWORD GetForwarderChain() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return data_.ForwarderChain;
+  }
+
+  DWORD GetNameRaw() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return data_.Name;
+  }
+
+  std::string GetName() const
+  {
+    if (!name_)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Name VA is invalid."});
+    }
+
+    return name_;
+  }
+
+  DWORD GetFirstThunk() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return data_.FirstThunk;
+  }
+
+  std::size_t GetNumThunks() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return num_thunks_;
+  }
+
+private:
+  friend class ImportTable;
+
+  PVOID base_{};
+  IMAGE_IMPORT_DESCRIPTOR data_ = IMAGE_IMPORT_DESCRIPTOR{};
+  char const* name_{};
+  std::size_t thunks_beg_{};
+  std::size_t num_thunks_{};
+};
+
+template <typename ThunkT> class ImportTableThunkRange
+{
+public:
+  using iterator = ThunkT*;
+
+  explicit ImportTableThunkRange(ThunkT* beg,
+                                 ThunkT* end) HADESMEM_DETAIL_NOEXCEPT
+    : beg_{beg},
+      end_{end}
+  {
+  }
+
+  iterator begin() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return beg_;
+  }
+
+  iterator end() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return end_;
+  }
+
+  std::size_t size() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return static_cast<std::size_t>(end_ - beg_);
+  }
+
+private:
+  ThunkT* beg_;
+  ThunkT* end_;
+};
+
+// Snapshot of the import directory. The descriptors, the name and address
+// tables of each descriptor and the module, hint and function names are
+// read in bulk on construction (a handful of reads per descriptor, rather
+// than several per import as with ImportDirList and ImportThunkList), and
+// are then available at memory speed. The snapshot is not updated if the
+// imports change, except by UpdateWrite.
+// Unlike ImportDirList, unusual layouts such as partially virtual
+// descriptors aren't handled (the directory is reported as invalid).
+class ImportTable
+{
+public:
+  using value_type = ImportTableDir;
+  using iterator = std::vector<ImportTableDir>::const_iterator;
+  using const_iterator = std::vector<ImportTableDir>::const_iterator;
+  using ThunkRange = ImportTableThunkRange<ImportTableThunk>;
+  using ConstThunkRange = ImportTableThunkRange<ImportTableThunk const>;
+
+  explicit ImportTable(Process const& process, PeFile const& pe_file)
+    : process_{&process}, pe_file_{&pe_file}
+  {
+    NtHeaders const nt_headers{process, pe_file};
+    DWORD const import_dir_rva =
+      nt_headers.GetDataDirectoryVirtualAddress(PeDataDir::Import);
+    // Windows will load images which don't specify a size for the import
+    // directory.
+    if (!import_dir_rva)
+    {
+      return;
+    }
+
+    auto const import_dir =
+      static_cast<std::uint8_t*>(RvaToVa(process, pe_file, import_dir_rva));
+    if (!import_dir)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Import directory is invalid."});
+    }
+
+    auto const base = static_cast<std::uint8_t*>(pe_file.GetBase());
+    std::uint8_t* const end =
+      base + (pe_file.GetType() == PeFileType::Data
+                ? pe_file.GetSize()
+                : nt_headers.GetSizeOfImage());
+
+    // If the Name is NULL then the other fields can be non-NULL but the
+    // entire entry will still be skipped by the Windows loader.
+    auto const descs = detail::ReadImportTableArray<IMAGE_IMPORT_DESCRIPTOR>(
+      process,
+      import_dir,
+      end,
+      [](IMAGE_IMPORT_DESCRIPTOR const& desc)
+      {
+        return !desc.Name || !desc.FirstThunk;
+      });
+
+    std::vector<detail::ImportTableString> strings;
+    std::vector<StringOwner> owners;
+    dirs_.reserve(descs.size());
+    for (std::size_t i = 0; i < descs.size(); ++i)
+    {
+      IMAGE_IMPORT_DESCRIPTOR const& desc = descs[i];
+      ImportTableDir dir;
+      dir.base_ = import_dir + i * sizeof(IMAGE_IMPORT_DESCRIPTOR);
+      dir.data_ = desc;
+      dir.thunks_beg_ = thunks_.size();
+      dirs_.push_back(dir);
+
+      if (auto const name_va =
+            static_cast<std::uint8_t*>(RvaToVa(process, pe_file, desc.Name)))
+      {
+        detail::ImportTableString const str = {name_va, 0, 0, false};
+        strings.push_back(str);
+        StringOwner const owner = {i, true};
+        owners.push_back(owner);
+      }
+
+      ReadThunks(desc, end, strings, owners);
+      dirs_.back().num_thunks_ = thunks_.size() - dirs_.back().thunks_beg_;
+    }
+
+    auto const names = std::make_shared<std::vector<char>>();
+    detail::ReadImportTableStrings(process, pe_file, end, strings, *names);
+    names_ = names;
+
+    for (std::size_t i = 0; i < strings.size(); ++i)
+    {
+      detail::ImportTableString const& str = strings[i];
+      if (!str.valid)
+      {
+        continue;
+      }
+
+      char const* const name = names->data() + str.offset + str.prefix_size;
+      StringOwner const& owner = owners[i];
+      if (owner.is_dir)
+      {
+        dirs_[owner.index].name_ = name;
+      }
+      else
+      {
+        thunks_[owner.index].name_ = name;
+      }
+    }
+  }
+
+  explicit ImportTable(Process&& process, PeFile const& pe_file) = delete;
+
+  explicit ImportTable(Process const& process, PeFile&& pe_file) = delete;
+
+  explicit ImportTable(Process&& process, PeFile&& pe_file) = delete;
+
+  const_iterator begin() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return std::begin(dirs_);
+  }
+
+  const_iterator cbegin() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return std::begin(dirs_);
+  }
+
+  const_iterator end() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return std::end(dirs_);
+  }
+
+  const_iterator cend() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return std::end(dirs_);
+  }
+
+  std::size_t size() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return dirs_.size();
+  }
+
+  ThunkRange GetThunks(ImportTableDir const& dir) HADESMEM_DETAIL_NOEXCEPT
+  {
+    HADESMEM_DETAIL_ASSERT(dir.thunks_beg_ + dir.num_thunks_ <=
+                           thunks_.size());
+    ImportTableThunk* const beg = thunks_.data() + dir.thunks_beg_;
+    return ThunkRange{beg, beg + dir.num_thunks_};
+  }
+
+  ConstThunkRange GetThunks(ImportTableDir const& dir) const
+    HADESMEM_DETAIL_NOEXCEPT
+  {
+    HADESMEM_DETAIL_ASSERT(dir.thunks_beg_ + dir.num_thunks_ <=
+                           thunks_.size());
+    ImportTableThunk const* const beg = thunks_.data() + dir.thunks_beg_;
+    return ConstThunkRange{beg, beg + dir.num_thunks_};
+  }
+
+  std::size_t GetNumThunks() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return thunks_.size();
+  }
+
+  // Writes the import address table entries of all thunks changed with
+  // ImportTableThunk::SetFunction as a single WriteTransaction, so the IAT
+  // has its protection changed once per region and adjacent entries are
+  // written together. Returns the number of entries written.
+  std::size_t UpdateWrite()
+  {
+    WriteTransaction transaction{*process_};
+    for (auto const& thunk : thunks_)
+    {
+      if (!thunk.modified_)
+      {
+        continue;
+      }
+
+      if (!thunk.iat_base_)
+      {
+        HADESMEM_DETAIL_THROW_EXCEPTION(
+          Error{} << ErrorString{"Import address table entry is invalid."});
+      }
+
+      transaction.Add(thunk.iat_base_, thunk.function_);
+    }
+
+    std::size_t const num_writes = transaction.GetNumRequests();
+    transaction.Commit();
+
+    for (auto& thunk : thunks_)
+    {
+      thunk.modified_ = false;
+    }
+
+    return num_writes;
+  }
+
+private:
+  // Which dir or thunk a queued string belongs to.
+  struct StringOwner
+  {
+    std::size_t index;
+    bool is_dir;
+  };
+
+  // Reads the name and address tables for a descriptor. The names are only
+  // queued in strings, to be read along with all the others.
+  void ReadThunks(IMAGE_IMPORT_DESCRIPTOR const& desc,
+                  std::uint8_t* end,
+                  std::vector<detail::ImportTableString>& strings,
+                  std::vector<StringOwner>& owners)
+  {
+    DWORD const names_rva =
+      desc.OriginalFirstThunk ? desc.OriginalFirstThunk : desc.FirstThunk;
+    auto const names_ptr =
+      static_cast<std::uint8_t*>(RvaToVa(*process_, *pe_file_, names_rva));
+    if (!names_ptr)
+    {
+      return;
+    }
+
+    auto const names = detail::ReadImportTableArray<IMAGE_THUNK_DATA>(
+      *process_,
+      names_ptr,
+      end,
+      [](IMAGE_THUNK_DATA const& thunk)
+      {
+        return !thunk.u1.AddressOfData;
+      });
+    if (names.empty())
+    {
+      return;
+    }
+
+    auto const iat_ptr = static_cast<std::uint8_t*>(
+      RvaToVa(*process_, *pe_file_, desc.FirstThunk));
+    std::vector<IMAGE_THUNK_DATA> iat;
+    if (iat_ptr == names_ptr)
+    {
+      iat = names;
+    }
+    else if (iat_ptr && iat_ptr < end)
+    {
+      std::size_t const num_iat = (std::min)(
+        names.size(),
+        static_cast<std::size_t>(end - iat_ptr) / sizeof(IMAGE_THUNK_DATA));
+      try
+      {
+        iat = ReadVector<IMAGE_THUNK_DATA>(*process_, iat_ptr, num_iat);
+      }
+      catch (Error const&)
+      {
+        iat.clear();
+      }
+    }
+
+    for (std::size_t i = 0; i < names.size(); ++i)
+    {
+      ImportTableThunk thunk;
+      thunk.base_ = names_ptr + i * sizeof(IMAGE_THUNK_DATA);
+      thunk.data_ = names[i].u1.AddressOfData;
+      if (i < iat.size())
+      {
+        thunk.iat_base_ = iat_ptr + i * sizeof(IMAGE_THUNK_DATA);
+        thunk.function_ = iat[i].u1.Function;
+      }
+      thunks_.push_back(thunk);
+
+      if (thunk.ByOrdinal())
+      {
+        continue;
+      }
+
+      if (auto const name_import = static_cast<std::uint8_t*>(RvaToVa(
+            *process_, *pe_file_, static_cast<DWORD>(thunk.data_))))
+      {
+        detail::ImportTableString const str = {
+          name_import, offsetof(IMAGE_IMPORT_BY_NAME, Name), 0, false};
+        strings.push_back(str);
+        StringOwner const owner = {thunks_.size() - 1, false};
+        owners.push_back(owner);
+      }
+    }
+  }
+
+  Process const* process_;
+  PeFile const* pe_file_;
+  std::vector<ImportTableDir> dirs_;
+  std::vector<ImportTableThunk> thunks_;
+  // Shared so that copies of the table (and their thunks) can keep pointing
+  // into it.
+  std::shared_ptr<std::vector<char> const> names_;
+};
+}
@@ -78,6 +78,7 @@ public:
   void UpdateWrite()
   {
     Write(*process_, base_, data_);
+    pe_file_->InvalidateHeaders();
   }
 
   bool IsValid() const
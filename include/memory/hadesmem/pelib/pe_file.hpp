@@ -3,12 +3,15 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <iosfwd>
+#include <iterator>
 #include <memory>
 #include <ostream>
 #include <utility>
+#include <vector>
 
 #include <windows.h>
 #include <winnt.h>
@@ -31,6 +34,249 @@ enum class PeFileType
   Data
 };
 
+namespace detail
+{
+struct PeFileSection
+{
+  DWORD virtual_beg;
+  // May wrap around, in which case the section never matches.
+  DWORD virtual_end;
+  DWORD raw_size;
+  DWORD raw_beg;
+  WORD index;
+};
+
+// The parts of the headers of a PeFileType::Data file needed to map RVAs to
+// file offsets.
+struct PeFileHeaders
+{
+  DWORD size_of_headers;
+  DWORD file_alignment;
+  DWORD size_of_image;
+  WORD num_sections;
+  // The entire section table lies outside the file.
+  bool virtual_section_table;
+  // Number of section headers (from the start of the table) which lie
+  // entirely inside the file.
+  WORD num_sections_in_file;
+  // Lowest VirtualAddress of the sections in the file.
+  DWORD min_virtual_beg;
+  // Whether any of the (non-empty) sections overlap.
+  bool overlapping;
+  // Non-empty sections in the file, sorted by VirtualAddress.
+  std::vector<PeFileSection> sections;
+};
+
+// Fills in the section information from the section headers which lie in
+// the file.
+inline void
+  InitPeFileSections(PeFileHeaders& headers,
+                     std::vector<IMAGE_SECTION_HEADER> const& section_headers)
+{
+  HADESMEM_DETAIL_ASSERT(!section_headers.empty());
+
+  headers.num_sections_in_file = static_cast<WORD>(section_headers.size());
+  headers.min_virtual_beg = section_headers[0].VirtualAddress;
+  headers.sections.clear();
+  for (WORD i = 0; i < headers.num_sections_in_file; ++i)
+  {
+    auto const& section_header = section_headers[i];
+    DWORD const virtual_beg = section_header.VirtualAddress;
+    DWORD const virtual_size = section_header.Misc.VirtualSize;
+    DWORD const raw_size = section_header.SizeOfRawData;
+    // If VirtualSize is zero then SizeOfRawData is used.
+    DWORD const virtual_end =
+      virtual_beg + (virtual_size ? virtual_size : raw_size);
+    headers.min_virtual_beg = (std::min)(headers.min_virtual_beg, virtual_beg);
+    if (virtual_end <= virtual_beg)
+    {
+      continue;
+    }
+
+    PeFileSection const section = {
+      virtual_beg, virtual_end, raw_size, section_header.PointerToRawData, i};
+    headers.sections.push_back(section);
+  }
+
+  auto& sections = headers.sections;
+  std::stable_sort(std::begin(sections),
+                   std::end(sections),
+                   [](PeFileSection const& lhs, PeFileSection const& rhs)
+                   {
+    return lhs.virtual_beg < rhs.virtual_beg;
+  });
+
+  headers.overlapping = false;
+  DWORD max_virtual_end = 0;
+  for (auto const& section : sections)
+  {
+    if (section.virtual_beg < max_virtual_end)
+    {
+      headers.overlapping = true;
+      break;
+    }
+
+    max_virtual_end = (std::max)(max_virtual_end, section.virtual_end);
+  }
+}
+
+// Returns the section containing rva. Where sections overlap, the first one
+// in the section table wins.
+inline PeFileSection const* FindPeFileSection(PeFileHeaders const& headers,
+                                              DWORD rva)
+{
+  auto const& sections = headers.sections;
+  if (headers.overlapping)
+  {
+    PeFileSection const* found = nullptr;
+    for (auto const& section : sections)
+    {
+      if (section.virtual_beg <= rva && rva < section.virtual_end &&
+          (!found || section.index < found->index))
+      {
+        found = &section;
+      }
+    }
+
+    return found;
+  }
+
+  auto iter = std::upper_bound(std::begin(sections),
+                               std::end(sections),
+                               rva,
+                               [](DWORD lhs, PeFileSection const& rhs)
+                               {
+    return lhs < rhs.virtual_beg;
+  });
+  if (iter == std::begin(sections))
+  {
+    return nullptr;
+  }
+
+  --iter;
+  return rva < iter->virtual_end ? &*iter : nullptr;
+}
+
+inline bool IsLowAlignmentHeaderRva(PeFileHeaders const& headers, DWORD rva)
+{
+  // Only applies in low alignment, otherwise it's invalid?
+  // Also only applies if the RVA is smaller than file alignment?
+  return headers.file_alignment < 200 || rva < headers.file_alignment;
+}
+
+// Maps a non-zero RVA to an offset in the file. Returns false if the RVA is
+// invalid.
+inline bool RvaToFileOffset(PeFileHeaders const& headers,
+                            DWORD file_size,
+                            DWORD rva,
+                            DWORD& offset)
+{
+  // Windows will load specially crafted images with no sections.
+  if (!headers.num_sections)
+  {
+    // In cases where the PE file has no sections it can apparently also have
+    // all sorts of messed up RVAs for data dirs etc... Make sure that none of
+    // them lie outside the file, because otherwise simply returning a direct
+    // offset from the base wouldn't work anyway...
+    if (rva > file_size)
+    {
+      return false;
+    }
+
+    offset = rva;
+    return true;
+  }
+
+  // SizeOfHeaders can be arbitrarily large, including the size of the
+  // entire file. RVAs inside the headers are treated as an offset from
+  // zero, rather than finding the 'true' location in a section.
+  if (rva < headers.size_of_headers)
+  {
+    offset = rva;
+    return IsLowAlignmentHeaderRva(headers, rva);
+  }
+
+  if (rva > headers.size_of_image)
+  {
+    return false;
+  }
+
+  // Virtual section table.
+  if (headers.virtual_section_table)
+  {
+    if (rva > file_size)
+    {
+      return false;
+    }
+
+    offset = rva;
+    return true;
+  }
+
+  if (PeFileSection const* const section = FindPeFileSection(headers, rva))
+  {
+    rva -= section->virtual_beg;
+
+    // If the RVA is outside the raw data (which would put it in the
+    // zero-fill of the virtual data) just return nullptr because it's
+    // invalid. Technically files like this will work when loaded by the
+    // PE loader due to the sections being mapped differention in memory
+    // to on disk, but if you want to inspect the file in that manner you
+    // should just use LoadLibrary with the appropriate flags for your
+    // scenario and then use PeFileType::Image.
+    if (rva > section->raw_size)
+    {
+      return false;
+    }
+
+    // If PointerToRawData is less than 0x200 it is rounded
+    // down to 0. Safe to mask it off unconditionally because
+    // it must be a multiple of FileAlignment.
+    rva += section->raw_beg & ~(0x1FFUL);
+
+    // If the RVA now lies outside the actual file just return nullptr
+    // because it's invalid.
+    if (rva >= file_size)
+    {
+      return false;
+    }
+
+    offset = rva;
+    return true;
+  }
+
+  // For a virtual section header, simply return nullptr. (Similar to above,
+  // except this time only the Nth entry onwards is virtual, rather than all
+  // the headers.)
+  if (headers.num_sections_in_file < headers.num_sections)
+  {
+    return false;
+  }
+
+  // This should be the 'normal' case. However sometimes the RVA is at a
+  // lower address than any of the sections, so we want to detect this so we
+  // can just treat the RVA as an offset from the module base (similar to
+  // when the image is loaded).
+  // Doing the same thing as in the SizeOfHeaders check above because we're
+  // not sure of better criteria to base it off. Perhaps it's correct now?
+  bool const in_header = rva < headers.min_virtual_beg;
+  if (in_header && rva < file_size)
+  {
+    offset = rva;
+    return IsLowAlignmentHeaderRva(headers, rva);
+  }
+
+  // Sample: nullSOH-XP (Corkami PE Corpus)
+  if (rva < headers.size_of_image && rva < file_size)
+  {
+    offset = rva;
+    return true;
+  }
+
+  return false;
+}
+}
+
 class PeFile
 {
 public:
@@ -41,7 +287,8 @@ public:
     : process_{&process},
       base_{static_cast<std::uint8_t*>(address)},
       type_{type},
-      size_{size}
+      size_{size},
+      headers_{std::make_shared<HeadersCache>()}
   {
     HADESMEM_DETAIL_ASSERT(base_ != 0);
     if (type == PeFileType::Data && !size)
@@ -88,11 +335,95 @@ public:
     return size_;
   }
 
+  // Parsed headers used by RvaToVa for PeFileType::Data. Read on first use
+  // and shared between copies, so call InvalidateHeaders after modifying the
+  // DOS header, NT headers or section table by any means other than the
+  // UpdateWrite member of DosHeader, NtHeaders or Section.
+  std::shared_ptr<detail::PeFileHeaders const> GetHeaders() const
+  {
+    auto headers = std::atomic_load(&headers_->headers);
+    if (!headers)
+    {
+      headers = ReadHeaders();
+      std::atomic_store(&headers_->headers, headers);
+    }
+
+    return headers;
+  }
+
+  void InvalidateHeaders() const
+  {
+    std::atomic_store(&headers_->headers,
+                      std::shared_ptr<detail::PeFileHeaders const>());
+  }
+
 private:
+  struct HeadersCache
+  {
+    std::shared_ptr<detail::PeFileHeaders const> headers;
+  };
+
+  std::shared_ptr<detail::PeFileHeaders const> ReadHeaders() const
+  {
+    IMAGE_DOS_HEADER dos_header = Read<IMAGE_DOS_HEADER>(*process_, base_);
+    if (dos_header.e_magic != IMAGE_DOS_SIGNATURE)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Invalid DOS header."});
+    }
+
+    BYTE* ptr_nt_headers = base_ + dos_header.e_lfanew;
+    IMAGE_NT_HEADERS nt_headers =
+      Read<IMAGE_NT_HEADERS>(*process_, ptr_nt_headers);
+    if (nt_headers.Signature != IMAGE_NT_SIGNATURE)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Invalid NT headers."});
+    }
+
+    auto headers = std::make_shared<detail::PeFileHeaders>();
+    headers->size_of_headers = nt_headers.OptionalHeader.SizeOfHeaders;
+    headers->file_alignment = nt_headers.OptionalHeader.FileAlignment;
+    headers->size_of_image = nt_headers.OptionalHeader.SizeOfImage;
+    headers->num_sections = nt_headers.FileHeader.NumberOfSections;
+    headers->virtual_section_table = false;
+    headers->num_sections_in_file = 0;
+    headers->min_virtual_beg = 0;
+    headers->overlapping = false;
+
+    auto const ptr_section_header = reinterpret_cast<PIMAGE_SECTION_HEADER>(
+      ptr_nt_headers + offsetof(IMAGE_NT_HEADERS, OptionalHeader) +
+      nt_headers.FileHeader.SizeOfOptionalHeader);
+    void const* const file_end = base_ + size_;
+    if (ptr_section_header >= file_end)
+    {
+      headers->virtual_section_table = true;
+      return headers;
+    }
+
+    std::size_t const max_sections_in_file = static_cast<std::size_t>(
+      (static_cast<BYTE const*>(file_end) -
+       reinterpret_cast<BYTE const*>(ptr_section_header)) /
+      sizeof(IMAGE_SECTION_HEADER));
+    headers->num_sections_in_file = static_cast<WORD>((std::min)(
+      static_cast<std::size_t>(headers->num_sections), max_sections_in_file));
+    if (!headers->num_sections_in_file)
+    {
+      return headers;
+    }
+
+    auto const section_headers = ReadVector<IMAGE_SECTION_HEADER>(
+      *process_, ptr_section_header, headers->num_sections_in_file);
+    detail::InitPeFileSections(*headers, section_headers);
+
+    return headers;
+  }
+
   Process const* process_;
   PBYTE base_;
   PeFileType type_;
   DWORD size_;
+  std::shared_ptr<HeadersCache> headers_;
 };
 
 inline bool operator==(PeFile const& lhs,
@@ -147,7 +478,8 @@ inline std::wostream& operator<<(std::wostream& lhs, PeFile const& rhs)
   return lhs;
 }
 
-inline PVOID RvaToVa(Process const& process, PeFile const& pe_file, DWORD rva)
+inline PVOID
+  RvaToVa(Process const& /*process*/, PeFile const& pe_file, DWORD rva)
 {
   PeFileType const type = pe_file.GetType();
   PBYTE base = static_cast<PBYTE>(pe_file.GetBase());
@@ -159,174 +491,11 @@ inline PVOID RvaToVa(Process const& process, PeFile const& pe_file, DWORD rva)
       return nullptr;
     }
 
-    IMAGE_DOS_HEADER dos_header = Read<IMAGE_DOS_HEADER>(process, base);
-    if (dos_header.e_magic != IMAGE_DOS_SIGNATURE)
-    {
-      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
-                                      << ErrorString{"Invalid DOS header."});
-    }
-
-    BYTE* ptr_nt_headers = base + dos_header.e_lfanew;
-    IMAGE_NT_HEADERS nt_headers =
-      Read<IMAGE_NT_HEADERS>(process, ptr_nt_headers);
-    if (nt_headers.Signature != IMAGE_NT_SIGNATURE)
-    {
-      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
-                                      << ErrorString{"Invalid NT headers."});
-    }
-
-    // Windows will load specially crafted images with no sections.
-    WORD num_sections = nt_headers.FileHeader.NumberOfSections;
-    if (!num_sections)
-    {
-      // In cases where the PE file has no sections it can apparently also have
-      // all sorts of messed up RVAs for data dirs etc... Make sure that none of
-      // them lie outside the file, because otherwise simply returning a direct
-      // offset from the base wouldn't work anyway...
-      if (rva > pe_file.GetSize())
-      {
-        return nullptr;
-      }
-      else
-      {
-        return base + rva;
-      }
-    }
-
-    // SizeOfHeaders can be arbitrarily large, including the size of the
-    // entire file. RVAs inside the headers are treated as an offset from
-    // zero, rather than finding the 'true' location in a section.
-    if (rva < nt_headers.OptionalHeader.SizeOfHeaders)
-    {
-      // Only applies in low alignment, otherwise it's invalid?
-      if (nt_headers.OptionalHeader.FileAlignment < 200)
-      {
-        return base + rva;
-      }
-      // Also only applies if the RVA is smaller than file alignment?
-      else if (rva < nt_headers.OptionalHeader.FileAlignment)
-      {
-        return base + rva;
-      }
-      else
-      {
-        return nullptr;
-      }
-    }
-
-    if (rva > nt_headers.OptionalHeader.SizeOfImage)
-    {
-      return nullptr;
-    }
-
-    auto ptr_section_header = reinterpret_cast<PIMAGE_SECTION_HEADER>(
-      ptr_nt_headers + offsetof(IMAGE_NT_HEADERS, OptionalHeader) +
-      nt_headers.FileHeader.SizeOfOptionalHeader);
-    void const* const file_end =
-      static_cast<std::uint8_t*>(pe_file.GetBase()) + pe_file.GetSize();
-    // Virtual section table.
-    if (ptr_section_header >= file_end)
-    {
-      if (rva > pe_file.GetSize())
-      {
-        return nullptr;
-      }
-      else
-      {
-        return base + rva;
-      }
-    }
-
-    bool in_header = true;
-    for (WORD i = 0; i < num_sections; ++i)
-    {
-      // For a virtual section header, simply return nullptr. (Similar to above,
-      // except this time only the Nth entry onwards is virtual, rather than all
-      // the headers.)
-      if (ptr_section_header + 1 > file_end)
-      {
-        return nullptr;
-      }
-
-      auto const section_header =
-        Read<IMAGE_SECTION_HEADER>(process, ptr_section_header);
-
-      DWORD const virtual_beg = section_header.VirtualAddress;
-      DWORD const virtual_size = section_header.Misc.VirtualSize;
-      DWORD const raw_size = section_header.SizeOfRawData;
-      // If VirtualSize is zero then SizeOfRawData is used.
-      DWORD const virtual_end =
-        virtual_beg + (virtual_size ? virtual_size : raw_size);
-      if (virtual_beg <= rva && rva < virtual_end)
-      {
-        rva -= virtual_beg;
-
-        // If the RVA is outside the raw data (which would put it in the
-        // zero-fill of the virtual data) just return nullptr because it's
-        // invalid. Technically files like this will work when loaded by the
-        // PE loader due to the sections being mapped differention in memory
-        // to on disk, but if you want to inspect the file in that manner you
-        // should just use LoadLibrary with the appropriate flags for your
-        // scenario and then use PeFileType::Image.
-        if (rva > raw_size)
-        {
-          return nullptr;
-        }
-
-        // If PointerToRawData is less than 0x200 it is rounded
-        // down to 0. Safe to mask it off unconditionally because
-        // it must be a multiple of FileAlignment.
-        rva += section_header.PointerToRawData & ~(0x1FFUL);
-
-        // If the RVA now lies outside the actual file just return nullptr
-        // because it's invalid.
-        if (rva >= pe_file.GetSize())
-        {
-          return nullptr;
-        }
-
-        return base + rva;
-      }
-
-      // This should be the 'normal' case. However sometimes the RVA is at a
-      // lower address than any of the sections, so we want to detect this so we
-      // can just treat the RVA as an offset from the module base (similar to
-      // when the image is loaded).
-      if (virtual_beg <= rva)
-      {
-        in_header = false;
-      }
-
-      ++ptr_section_header;
-    }
-
-    // Doing the same thing as in the SizeOfHeaders check above because we're
-    // not sure of better criteria to base it off. Perhaps it's correct now?
-    if (in_header && rva < pe_file.GetSize())
-    {
-      // Only applies in low alignment, otherwise it's invalid?
-      if (nt_headers.OptionalHeader.FileAlignment < 200)
-      {
-        return base + rva;
-      }
-      // Also only applies if the RVA is smaller than file alignment?
-      else if (rva < nt_headers.OptionalHeader.FileAlignment)
-      {
-        return base + rva;
-      }
-      else
-      {
-        return nullptr;
-      }
-    }
-
-    // Sample: nullSOH-XP (Corkami PE Corpus)
-    if (rva < nt_headers.OptionalHeader.SizeOfImage && rva < pe_file.GetSize())
-    {
-      return base + rva;
-    }
-
-    return nullptr;
+    auto const headers = pe_file.GetHeaders();
+    DWORD offset = 0;
+    return detail::RvaToFileOffset(*headers, pe_file.GetSize(), rva, offset)
+             ? base + offset
+             : nullptr;
   }
   else if (type == PeFileType::Image)
   {
@@ -0,0 +1,398 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include <windows.h>
+#include <winnt.h>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/snapshot_diff.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/pelib/nt_headers.hpp>
+#include <hadesmem/pelib/pe_file.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/read.hpp>
+#include <hadesmem/write_transaction.hpp>
+
+namespace hadesmem
+{
+namespace detail
+{
+struct RelocationTableEntries
+{
+  std::vector<std::uint8_t> types;
+  std::vector<std::uint16_t> offsets;
+};
+
+// Splits relocation entries into their types and offsets. Kept free of
+// branches and writing to separate arrays so that it can be vectorized.
+inline void DecodeRelocations(std::uint16_t const* entries,
+                              std::size_t count,
+                              std::uint8_t* types,
+                              std::uint16_t* offsets) HADESMEM_DETAIL_NOEXCEPT
+{
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    types[i] = static_cast<std::uint8_t>(entries[i] >> 12);
+    offsets[i] = static_cast<std::uint16_t>(entries[i] & 0x0FFF);
+  }
+}
+
+template <typename T>
+inline void AddToRelocationTarget(std::uint8_t* image,
+                                  std::size_t image_size,
+                                  ULONGLONG rva,
+                                  T value)
+{
+  if (rva > image_size || image_size - rva < sizeof(T))
+  {
+    HADESMEM_DETAIL_THROW_EXCEPTION(
+      Error{} << ErrorString{"Relocation target is out of bounds."});
+  }
+
+  // Targets aren't necessarily aligned.
+  T target;
+  std::memcpy(&target, image + rva, sizeof(T));
+  target = static_cast<T>(target + value);
+  std::memcpy(image + rva, &target, sizeof(T));
+}
+}
+
+class RelocationTableBlock
+{
+public:
+  void* GetBase() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return base_;
+  }
+
+  DWORD GetVirtualAddress() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return data_.VirtualAddress;
+  }
+
+  DWORD GetSizeOfBlock() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return data_.SizeOfBlock;
+  }
+
+  DWORD GetNumberOfRelocations() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return num_relocs_;
+  }
+
+  std::uint8_t GetType(DWORD index) const HADESMEM_DETAIL_NOEXCEPT
+  {
+    HADESMEM_DETAIL_ASSERT(index < num_relocs_);
+    return types_[index];
+  }
+
+  std::uint16_t GetOffset(DWORD index) const HADESMEM_DETAIL_NOEXCEPT
+  {
+    HADESMEM_DETAIL_ASSERT(index < num_relocs_);
+    return offsets_[index];
+  }
+
+private:
+  friend class RelocationTable;
+
+  RelocationTableBlock() HADESMEM_DETAIL_NOEXCEPT
+  {
+  }
+
+  std::uint8_t* base_{};
+  IMAGE_BASE_RELOCATION data_ = IMAGE_BASE_RELOCATION{};
+  DWORD num_relocs_{};
+  // Point into the entries of the table.
+  std::uint8_t const* types_{};
+  std::uint16_t const* offsets_{};
+};
+
+// Snapshot of the relocation directory. The whole directory is read at once
+// on construction and the entries of each block are decoded in bulk, rather
+// than reading each block header and entry separately as with
+// RelocationBlockList and RelocationList. Blocks are handled the same way as
+// RelocationBlockList, so the table stops at the first invalid block.
+class RelocationTable
+{
+public:
+  using value_type = RelocationTableBlock;
+  using iterator = std::vector<RelocationTableBlock>::const_iterator;
+  using const_iterator = std::vector<RelocationTableBlock>::const_iterator;
+
+  explicit RelocationTable(Process const& process, PeFile const& pe_file)
+  {
+    NtHeaders const nt_headers{process, pe_file};
+    DWORD const reloc_dir_rva =
+      nt_headers.GetDataDirectoryVirtualAddress(PeDataDir::BaseReloc);
+    DWORD const size = nt_headers.GetDataDirectorySize(PeDataDir::BaseReloc);
+    if (!reloc_dir_rva || !size)
+    {
+      return;
+    }
+
+    auto const reloc_dir =
+      static_cast<std::uint8_t*>(RvaToVa(process, pe_file, reloc_dir_rva));
+    if (!reloc_dir)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Relocation directory is invalid."});
+    }
+
+    // Sample: virtrelocXP.exe
+    auto const file_end =
+      static_cast<std::uint8_t*>(pe_file.GetBase()) + pe_file.GetSize();
+    if (pe_file.GetType() == PeFileType::Data &&
+        (reloc_dir > file_end ||
+         static_cast<std::size_t>(file_end - reloc_dir) < size))
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Relocation directory is invalid."});
+    }
+
+    std::size_t const num_words = size / sizeof(WORD);
+    auto const words = ReadVector<std::uint16_t>(process, reloc_dir, num_words);
+
+    auto const entries = std::make_shared<detail::RelocationTableEntries>();
+    entries->types.resize(num_words);
+    entries->offsets.resize(num_words);
+
+    std::size_t const header_words =
+      sizeof(IMAGE_BASE_RELOCATION) / sizeof(WORD);
+    std::vector<std::size_t> blocks_beg;
+    std::size_t pos = 0;
+    std::size_t num_relocs = 0;
+    while (num_words - pos >= header_words)
+    {
+      RelocationTableBlock block;
+      block.base_ = reloc_dir + pos * sizeof(WORD);
+      std::memcpy(&block.data_, &words[pos], sizeof(block.data_));
+
+      DWORD const size_of_block = block.data_.SizeOfBlock;
+      if (size_of_block && size_of_block < sizeof(IMAGE_BASE_RELOCATION))
+      {
+        break;
+      }
+
+      std::size_t const count =
+        size_of_block
+          ? (size_of_block - sizeof(IMAGE_BASE_RELOCATION)) / sizeof(WORD)
+          : 0;
+      if (num_words - pos - header_words < count)
+      {
+        break;
+      }
+
+      detail::DecodeRelocations(words.data() + pos + header_words,
+                                count,
+                                entries->types.data() + num_relocs,
+                                entries->offsets.data() + num_relocs);
+      block.num_relocs_ = static_cast<DWORD>(count);
+      blocks_.push_back(block);
+      blocks_beg.push_back(num_relocs);
+
+      num_relocs += count;
+      pos += header_words + count;
+    }
+
+    entries->types.resize(num_relocs);
+    entries->offsets.resize(num_relocs);
+    for (std::size_t i = 0; i < blocks_.size(); ++i)
+    {
+      blocks_[i].types_ = entries->types.data() + blocks_beg[i];
+      blocks_[i].offsets_ = entries->offsets.data() + blocks_beg[i];
+    }
+    entries_ = entries;
+  }
+
+  explicit RelocationTable(Process&& process, PeFile const& pe_file) = delete;
+
+  explicit RelocationTable(Process const& process, PeFile&& pe_file) = delete;
+
+  explicit RelocationTable(Process&& process, PeFile&& pe_file) = delete;
+
+  const_iterator begin() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return std::begin(blocks_);
+  }
+
+  const_iterator cbegin() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return std::begin(blocks_);
+  }
+
+  const_iterator end() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return std::end(blocks_);
+  }
+
+  const_iterator cend() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return std::end(blocks_);
+  }
+
+  std::size_t size() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return blocks_.size();
+  }
+
+  std::size_t GetNumberOfRelocations() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return entries_ ? entries_->types.size() : 0;
+  }
+
+  // Adds delta to every relocation target in image, which must be a copy of
+  // the image in memory (i.e. laid out by RVA rather than by file offset)
+  // of image_size bytes. Returns the number of relocations applied.
+  std::size_t
+    Apply(void* image, std::size_t image_size, ULONGLONG delta) const
+  {
+    auto const image_beg = static_cast<std::uint8_t*>(image);
+    std::size_t num_applied = 0;
+    for (auto const& block : blocks_)
+    {
+      ULONGLONG const block_rva = block.GetVirtualAddress();
+      DWORD const count = block.GetNumberOfRelocations();
+      for (DWORD i = 0; i < count; ++i)
+      {
+        ULONGLONG const rva = block_rva + block.offsets_[i];
+        switch (block.types_[i])
+        {
+        case IMAGE_REL_BASED_ABSOLUTE:
+          continue;
+
+        case IMAGE_REL_BASED_HIGHLOW:
+          detail::AddToRelocationTarget(
+            image_beg, image_size, rva, static_cast<DWORD>(delta));
+          break;
+
+        case IMAGE_REL_BASED_DIR64:
+          detail::AddToRelocationTarget(image_beg, image_size, rva, delta);
+          break;
+
+        case IMAGE_REL_BASED_HIGH:
+          detail::AddToRelocationTarget(
+            image_beg,
+            image_size,
+            rva,
+            static_cast<WORD>(static_cast<DWORD>(delta) >> 16));
+          break;
+
+        case IMAGE_REL_BASED_LOW:
+          detail::AddToRelocationTarget(
+            image_beg, image_size, rva, static_cast<WORD>(delta));
+          break;
+
+        case IMAGE_REL_BASED_HIGHADJ:
+          ApplyHighAdj(block, i, image_beg, image_size, rva, delta);
+          ++i;
+          break;
+
+        default:
+          HADESMEM_DETAIL_THROW_EXCEPTION(
+            Error{} << ErrorString{"Unsupported relocation type."});
+        }
+
+        ++num_applied;
+      }
+    }
+
+    return num_applied;
+  }
+
+private:
+  // The low half of the target is stored in the following entry, and is
+  // needed to carry into the high half.
+  static void ApplyHighAdj(RelocationTableBlock const& block,
+                           DWORD index,
+                           std::uint8_t* image,
+                           std::size_t image_size,
+                           ULONGLONG rva,
+                           ULONGLONG delta)
+  {
+    if (index + 1 >= block.GetNumberOfRelocations() || rva > image_size ||
+        image_size - rva < sizeof(WORD))
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Relocation is invalid."});
+    }
+
+    auto const low = static_cast<std::uint16_t>(
+      (static_cast<std::uint32_t>(block.types_[index + 1]) << 12) |
+      block.offsets_[index + 1]);
+    WORD high;
+    std::memcpy(&high, image + rva, sizeof(high));
+    DWORD value = static_cast<DWORD>(high) << 16;
+    value += static_cast<DWORD>(static_cast<std::int16_t>(low));
+    value += static_cast<DWORD>(delta);
+    value += 0x8000;
+    high = static_cast<WORD>(value >> 16);
+    std::memcpy(image + rva, &high, sizeof(high));
+  }
+
+  std::vector<RelocationTableBlock> blocks_;
+  // Shared so that copies of the table (and their blocks) can keep pointing
+  // into it.
+  std::shared_ptr<detail::RelocationTableEntries const> entries_;
+};
+
+// Rebases an image laid out in memory (such as an image being manually
+// mapped) by adding delta to each relocation target and to the image base in
+// its headers. The image is read into a local copy, the relocations are
+// applied there and only the pages which changed are written back (with a
+// WriteTransaction, so read-only sections are handled and nothing is written
+// if a relocation is invalid). Returns the number of relocations applied.
+inline std::size_t ApplyRelocations(Process const& process,
+                                    PeFile const& pe_file,
+                                    ULONGLONG delta)
+{
+  if (pe_file.GetType() != PeFileType::Image)
+  {
+    HADESMEM_DETAIL_THROW_EXCEPTION(
+      Error{} << ErrorString{"Image must be laid out in memory."});
+  }
+
+  RelocationTable const relocations{process, pe_file};
+  NtHeaders nt_headers{process, pe_file};
+  auto const base = static_cast<std::uint8_t*>(pe_file.GetBase());
+  std::vector<std::uint8_t> const image_orig =
+    ReadVectorEx<std::uint8_t>(process,
+                               base,
+                               nt_headers.GetSizeOfImage(),
+                               ReadFlags::kZeroFillReserved);
+  std::vector<std::uint8_t> image{image_orig};
+  std::size_t const num_applied =
+    relocations.Apply(image.data(), image.size(), delta);
+
+  // Merge changes up to a page apart, so the transaction gets roughly one
+  // write per touched page rather than one per fixup.
+  SYSTEM_INFO sys_info{};
+  ::GetSystemInfo(&sys_info);
+
+  WriteTransaction transaction{process};
+  detail::DiffSnapshots(
+    image_orig.data(),
+    image.data(),
+    image.size(),
+    sys_info.dwPageSize,
+    [&](std::size_t offset, std::size_t size)
+    {
+      transaction.Add(base + offset, image.data() + offset, size);
+    });
+  transaction.Commit();
+
+  nt_headers.SetImageBase(
+    static_cast<ULONG_PTR>(nt_headers.GetImageBase() + delta));
+  nt_headers.UpdateWrite();
+  return num_applied;
+}
+}
@@ -86,6 +86,7 @@ public:
   void UpdateWrite()
   {
     Write(*process_, base_, data_);
+    pe_file_->InvalidateHeaders();
   }
 
   std::string GetName() const
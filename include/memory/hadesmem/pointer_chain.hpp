@@ -0,0 +1,253 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <windows.h>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/read_impl.hpp>
+#include <hadesmem/detail/static_assert.hpp>
+#include <hadesmem/detail/type_traits.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/process.hpp>
+
+namespace hadesmem
+{
+// Describes a multi-level pointer such as [[[base + 4] + 0] + 4C] + 64. Level
+// 0 is at base, and the pointer at the level base plus the level's offset is
+// the base of the next level. The resolved address is the base of the last
+// level plus its offset.
+//
+// Each level may have a window (a range relative to the level base) which is
+// read in full whenever that level is resolved, so sibling fields can be
+// accessed via GetField without further reads.
+//
+// Level bases are cached. Resolve always re-reads level 0 and every level
+// with a window, but an intermediate level without a window is only re-read
+// if a level above it changed or the chain has been invalidated since it was
+// last read. In the common case (nothing moved, no windows) resolving costs a
+// single read. Call Invalidate when the target may have rebuilt an object
+// further down the chain (e.g. after a level load).
+class PointerChain
+{
+public:
+  explicit PointerChain(Process const& process,
+                        PVOID base,
+                        std::vector<std::ptrdiff_t> const& offsets)
+    : process_{&process},
+      base_{static_cast<std::uint8_t*>(base)},
+      levels_(offsets.size()),
+      generation_{0},
+      num_reads_{0}
+  {
+    if (offsets.empty())
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Pointer chain must have at least one level."});
+    }
+
+    for (std::size_t i = 0; i < offsets.size(); ++i)
+    {
+      levels_[i].offset = offsets[i];
+    }
+  }
+
+  explicit PointerChain(Process&& process,
+                        PVOID base,
+                        std::vector<std::ptrdiff_t> const& offsets) = delete;
+
+  // For every level but the last the window must contain the pointer to the
+  // next level.
+  void SetWindow(std::size_t level, std::ptrdiff_t offset, std::size_t size)
+  {
+    HADESMEM_DETAIL_ASSERT(level < levels_.size());
+
+    Level& l = levels_[level];
+    if (level + 1 < levels_.size() &&
+        (l.offset < offset ||
+         static_cast<std::size_t>(l.offset - offset) + sizeof(void*) > size))
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Window does not contain the next pointer."});
+    }
+
+    l.window_offset = offset;
+    l.window.assign(size, 0);
+    l.window_valid = false;
+  }
+
+  PVOID Resolve()
+  {
+    bool changed = false;
+    std::uint8_t* level_base = base_;
+    for (std::size_t i = 0; i < levels_.size(); ++i)
+    {
+      Level& l = levels_[i];
+      bool const is_last = (i + 1 == levels_.size());
+
+      if (!l.valid || l.generation != generation_ || l.base != level_base)
+      {
+        changed = true;
+      }
+
+      l.base = level_base;
+      l.generation = generation_;
+      l.valid = true;
+
+      if (!l.window.empty())
+      {
+        ReadLevel(l, l.window_offset, l.window.data(), l.window.size());
+        l.window_valid = true;
+      }
+
+      if (is_last)
+      {
+        break;
+      }
+
+      std::uint8_t* next = l.next;
+      if (!l.window.empty())
+      {
+        std::size_t const next_offset =
+          static_cast<std::size_t>(l.offset - l.window_offset);
+        std::memcpy(&next, &l.window[next_offset], sizeof(next));
+      }
+      else if (i == 0 || changed)
+      {
+        ReadLevel(l, l.offset, &next, sizeof(next));
+      }
+
+      if (!next)
+      {
+        l.valid = false;
+        HADESMEM_DETAIL_THROW_EXCEPTION(
+          Error{} << ErrorString{"Null pointer in pointer chain."}
+                  << ErrorCodeOther{static_cast<DWORD_PTR>(i)});
+      }
+
+      l.next = next;
+      level_base = next;
+    }
+
+    return levels_.back().base + levels_.back().offset;
+  }
+
+  // Resolves the chain reading every level.
+  PVOID ResolveUncached()
+  {
+    Invalidate();
+    return Resolve();
+  }
+
+  void Invalidate() HADESMEM_DETAIL_NOEXCEPT
+  {
+    ++generation_;
+  }
+
+  std::uint32_t GetGeneration() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return generation_;
+  }
+
+  std::size_t GetNumLevels() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return levels_.size();
+  }
+
+  // Base of the level as of the last resolution.
+  PVOID GetLevelBase(std::size_t level) const
+  {
+    HADESMEM_DETAIL_ASSERT(level < levels_.size());
+    return levels_[level].base;
+  }
+
+  // Reads a field from the window of the level as of the last resolution.
+  // offset is relative to the level base (like the level offsets).
+  template <typename T>
+  T GetField(std::size_t level, std::ptrdiff_t offset) const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+    HADESMEM_DETAIL_STATIC_ASSERT(std::is_default_constructible<T>::value);
+
+    HADESMEM_DETAIL_ASSERT(level < levels_.size());
+
+    Level const& l = levels_[level];
+    if (!l.window_valid || offset < l.window_offset ||
+        static_cast<std::size_t>(offset - l.window_offset) + sizeof(T) >
+          l.window.size())
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Field is outside of the level window."});
+    }
+
+    T data;
+    std::memcpy(std::addressof(data),
+                &l.window[static_cast<std::size_t>(offset - l.window_offset)],
+                sizeof(T));
+    return data;
+  }
+
+  // Number of reads issued, for checking how effective the cache is.
+  std::uint64_t GetNumReads() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return num_reads_;
+  }
+
+private:
+  struct Level
+  {
+    Level()
+      : offset{0},
+        window_offset{0},
+        base{nullptr},
+        next{nullptr},
+        generation{0},
+        valid{false},
+        window_valid{false}
+    {
+    }
+
+    std::ptrdiff_t offset;
+    std::ptrdiff_t window_offset;
+    std::vector<std::uint8_t> window;
+    std::uint8_t* base;
+    std::uint8_t* next;
+    std::uint32_t generation;
+    bool valid;
+    bool window_valid;
+  };
+
+  void ReadLevel(Level& level,
+                 std::ptrdiff_t offset,
+                 void* data,
+                 std::size_t len)
+  {
+    ++num_reads_;
+    try
+    {
+      detail::ReadImpl(*process_, level.base + offset, data, len);
+    }
+    catch (...)
+    {
+      level.valid = false;
+      level.window_valid = false;
+      throw;
+    }
+  }
+
+  Process const* process_;
+  std::uint8_t* base_;
+  std::vector<Level> levels_;
+  std::uint32_t generation_;
+  std::uint64_t num_reads_;
+};
+}
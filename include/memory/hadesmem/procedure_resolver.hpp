@@ -0,0 +1,180 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <windows.h>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/alias_cast.hpp>
+#include <hadesmem/detail/static_assert.hpp>
+#include <hadesmem/detail/str_conv.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/module.hpp>
+#include <hadesmem/pelib/export.hpp>
+#include <hadesmem/pelib/export_index.hpp>
+#include <hadesmem/pelib/pe_file.hpp>
+#include <hadesmem/process.hpp>
+
+namespace hadesmem
+{
+// Resolves exports to addresses, following forwarders. Keeps an ExportIndex
+// for each module it has looked in, the handles of forwarder target modules
+// and the results of resolved forwarders, so resolving many procedures only
+// reads each module's export tables once. Keep one around for as long as
+// the modules involved stay loaded, rather than using FindProcedure (which
+// starts from scratch on every call). Nothing is ever invalidated, so call
+// Clear if modules may have been unloaded.
+class ProcedureResolver
+{
+public:
+  explicit ProcedureResolver(Process const& process) : process_{&process}
+  {
+  }
+
+  explicit ProcedureResolver(Process&& process) = delete;
+
+  // Returns nullptr if there is no such export.
+  FARPROC Find(HMODULE module, std::string const& name)
+  {
+    return FindImpl(module, name, 0);
+  }
+
+  // Returns nullptr if there is no such export.
+  FARPROC Find(HMODULE module, WORD ordinal)
+  {
+    return FindImpl(module, ordinal, 0);
+  }
+
+  void Clear()
+  {
+    modules_.clear();
+    forwarder_modules_.clear();
+    forwarders_.clear();
+  }
+
+private:
+  // Deep enough for any real chain, but stops a cycle of forwarders from
+  // recursing forever.
+  static std::size_t const kMaxForwarderDepth = 32;
+
+  // After this many lookups by name in a module, read all of its names into
+  // a hash map rather than continuing to binary search.
+  static std::size_t const kNameMapThreshold = 16;
+
+  struct ModuleExports
+  {
+    explicit ModuleExports(Process const& process, HMODULE module)
+      : pe_file{process, module, PeFileType::Image, 0},
+        index{process, pe_file},
+        num_name_lookups{0}
+    {
+    }
+
+    PeFile pe_file;
+    ExportIndex index;
+    std::size_t num_name_lookups;
+  };
+
+  ModuleExports& GetModuleExports(HMODULE module)
+  {
+    auto iter = modules_.find(module);
+    if (iter == std::end(modules_))
+    {
+      iter = modules_.emplace(module,
+                              std::unique_ptr<ModuleExports>(
+                                new ModuleExports(*process_, module))).first;
+    }
+
+    return *iter->second;
+  }
+
+  FARPROC FindImpl(HMODULE module, std::string const& name, std::size_t depth)
+  {
+    ModuleExports& exports = GetModuleExports(module);
+    if (++exports.num_name_lookups == kNameMapThreshold)
+    {
+      exports.index.BuildNameMap();
+    }
+
+    WORD procedure_number = 0;
+    if (!exports.index.FindProcedureNumber(name, procedure_number) ||
+        !exports.index.HasProcedure(procedure_number))
+    {
+      return nullptr;
+    }
+
+    return Resolve(exports.index.GetExport(procedure_number), depth);
+  }
+
+  FARPROC FindImpl(HMODULE module, WORD ordinal, std::size_t depth)
+  {
+    ModuleExports& exports = GetModuleExports(module);
+    if (!exports.index.HasProcedure(ordinal))
+    {
+      return nullptr;
+    }
+
+    return Resolve(exports.index.GetExport(ordinal), depth);
+  }
+
+  FARPROC Resolve(Export const& e, std::size_t depth)
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(sizeof(FARPROC) == sizeof(void*));
+
+    if (!e.IsForwarded())
+    {
+      return detail::AliasCast<FARPROC>(e.GetVa());
+    }
+
+    if (depth >= kMaxForwarderDepth)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Forwarder chain too long."});
+    }
+
+    std::string const forwarder{e.GetForwarder()};
+    auto const cached = forwarders_.find(forwarder);
+    if (cached != std::end(forwarders_))
+    {
+      return cached->second;
+    }
+
+    HMODULE const forwarder_module =
+      GetForwarderModule(e.GetForwarderModule());
+    FARPROC const func =
+      e.IsForwardedByOrdinal()
+        ? FindImpl(forwarder_module, e.GetForwarderOrdinal(), depth + 1)
+        : FindImpl(forwarder_module, e.GetForwarderFunction(), depth + 1);
+    if (func)
+    {
+      forwarders_[forwarder] = func;
+    }
+
+    return func;
+  }
+
+  HMODULE GetForwarderModule(std::string const& name)
+  {
+    auto const iter = forwarder_modules_.find(name);
+    if (iter != std::end(forwarder_modules_))
+    {
+      return iter->second;
+    }
+
+    Module const module{*process_, detail::MultiByteToWideChar(name)};
+    forwarder_modules_[name] = module.GetHandle();
+    return module.GetHandle();
+  }
+
+  Process const* process_;
+  std::map<HMODULE, std::unique_ptr<ModuleExports>> modules_;
+  std::map<std::string, HMODULE> forwarder_modules_;
+  std::map<std::string, FARPROC> forwarders_;
+};
+}
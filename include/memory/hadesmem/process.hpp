@@ -13,24 +13,37 @@
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/region_cache.hpp>
 #include <hadesmem/detail/smart_handle.hpp>
 #include <hadesmem/detail/trace.hpp>
 #include <hadesmem/detail/winapi.hpp>
 #include <hadesmem/error.hpp>
+#include <hadesmem/local_memory_backend.hpp>
+#include <hadesmem/memory_backend.hpp>
+#include <hadesmem/remote_memory_cache.hpp>
 
 namespace hadesmem
 {
 class Process
 {
 public:
-  explicit Process(DWORD id) : handle_{OpenProcess(id)}, id_{id}
+  // If id refers to the current process then memory is accessed directly
+  // (see LocalMemoryBackend). Use SetMemoryBackend(nullptr) to go through the
+  // process handle instead.
+  explicit Process(DWORD id)
+    : handle_{OpenProcess(id)},
+      id_{id},
+      memory_backend_{CreateMemoryBackend(id)}
   {
     CheckWoW64();
   }
 
   Process(Process const& other)
     : handle_{DuplicateHandle(other.id_, other.handle_.GetHandle())},
-      id_{other.id_}
+      id_{other.id_},
+      region_cache_{other.region_cache_},
+      memory_cache_{other.memory_cache_},
+      memory_backend_{other.memory_backend_}
   {
   }
 
@@ -44,7 +57,10 @@ public:
 
   Process(Process&& other) HADESMEM_DETAIL_NOEXCEPT
     : handle_{std::move(other.handle_)},
-      id_{other.id_}
+      id_{other.id_},
+      region_cache_{std::move(other.region_cache_)},
+      memory_cache_{std::move(other.memory_cache_)},
+      memory_backend_{std::move(other.memory_backend_)}
   {
     other.id_ = 0;
   }
@@ -55,6 +71,9 @@ public:
 
     handle_ = std::move(other.handle_);
     id_ = other.id_;
+    region_cache_ = std::move(other.region_cache_);
+    memory_cache_ = std::move(other.memory_cache_);
+    memory_backend_ = std::move(other.memory_backend_);
 
     other.id_ = 0;
 
@@ -76,6 +95,77 @@ public:
     return handle_.GetHandle();
   }
 
+  // Caches region information so that reads and writes don't have to query
+  // the target on every call. The cache is shared between copies. Regions
+  // changed through hadesmem (Alloc, Free, Protect, etc.) are invalidated
+  // automatically, but changes made by any other means (including by the
+  // target itself) require a call to InvalidateRegionCache. A stale entry
+  // which causes an access to fail is also dropped and the access retried.
+  void EnableRegionCache()
+  {
+    if (!region_cache_)
+    {
+      region_cache_ = std::make_shared<detail::RegionCache>();
+    }
+  }
+
+  void DisableRegionCache() HADESMEM_DETAIL_NOEXCEPT
+  {
+    region_cache_.reset();
+  }
+
+  bool IsRegionCacheEnabled() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return !!region_cache_;
+  }
+
+  void InvalidateRegionCache() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    if (region_cache_)
+    {
+      region_cache_->Invalidate();
+    }
+  }
+
+  detail::RegionCache* GetRegionCache() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return region_cache_.get();
+  }
+
+  // Serves all reads through this process from the given page cache (see
+  // RemoteMemoryCache). Pass nullptr to detach it. The cache is shared
+  // between copies.
+  void SetMemoryCache(std::shared_ptr<RemoteMemoryCache> const& cache)
+    HADESMEM_DETAIL_NOEXCEPT
+  {
+    memory_cache_ = cache;
+  }
+
+  RemoteMemoryCache* GetMemoryCache() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return memory_cache_.get();
+  }
+
+  // Redirects all memory access through this process to the given backend
+  // (see MemoryBackend). Pass nullptr to go back to using the process handle.
+  // The backend is shared between copies. Both caches are invalidated, as
+  // their contents describe the previous backend.
+  void SetMemoryBackend(std::shared_ptr<MemoryBackend> const& backend)
+    HADESMEM_DETAIL_NOEXCEPT
+  {
+    memory_backend_ = backend;
+    InvalidateRegionCache();
+    if (memory_cache_)
+    {
+      memory_cache_->Invalidate();
+    }
+  }
+
+  MemoryBackend* GetMemoryBackend() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return memory_backend_.get();
+  }
+
   void Cleanup()
   {
     if (id_ != ::GetCurrentProcessId())
@@ -88,6 +178,9 @@ public:
     }
 
     id_ = 0;
+    region_cache_.reset();
+    memory_cache_.reset();
+    memory_backend_.reset();
   }
 
 private:
@@ -117,6 +210,9 @@ private:
 
       id_ = 0;
       handle_ = nullptr;
+      region_cache_.reset();
+      memory_cache_.reset();
+      memory_backend_.reset();
     }
   }
 
@@ -127,6 +223,13 @@ private:
              : detail::OpenProcessAllAccess(id).Detach();
   }
 
+  std::shared_ptr<MemoryBackend> CreateMemoryBackend(DWORD id) const
+  {
+    return id == ::GetCurrentProcessId()
+             ? std::make_shared<LocalMemoryBackend>()
+             : std::shared_ptr<MemoryBackend>();
+  }
+
   HANDLE DuplicateHandle(DWORD id, HANDLE handle) const
   {
     return id == ::GetCurrentProcessId()
@@ -136,6 +239,9 @@ private:
 
   detail::SmartHandle handle_;
   DWORD id_;
+  std::shared_ptr<detail::RegionCache> region_cache_;
+  std::shared_ptr<RemoteMemoryCache> memory_cache_;
+  std::shared_ptr<MemoryBackend> memory_backend_;
 };
 
 inline bool operator==(Process const& lhs,
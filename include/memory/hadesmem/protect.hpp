@@ -57,6 +57,7 @@ inline bool IsBadProtect(Process const& process, LPCVOID address)
 inline DWORD Protect(Process const& process, LPVOID address, DWORD protect)
 {
   MEMORY_BASIC_INFORMATION const mbi = detail::Query(process, address);
+  detail::InvalidateRegionCache(process, mbi.BaseAddress, mbi.RegionSize);
   return detail::Protect(process, mbi, protect);
 }
 }
@@ -3,8 +3,12 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
 #include <exception>
 #include <iterator>
 #include <memory>
@@ -22,6 +26,7 @@
 #include <hadesmem/detail/type_traits.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/protect.hpp>
+#include <hadesmem/remote_memory_cache.hpp>
 
 namespace hadesmem
 {
@@ -32,6 +37,151 @@ template <typename T> struct ReadStringTraits
   // 4KB default chunk size
   static std::size_t const kChunkLen = 0x1000;
 };
+
+// Most strings are short, so this much is read in one go (without querying
+// the region or changing protection) before falling back to reading chunks.
+// The read never crosses a page boundary.
+std::size_t const kReadStringSmallLen = 64;
+
+std::size_t const kReadStringPageSize = 0x1000;
+
+// The CRT versions of these are vectorized.
+inline char const* FindStringTerminator(char const* beg, char const* end)
+{
+  auto const found = static_cast<char const*>(
+    std::memchr(beg, 0, static_cast<std::size_t>(end - beg)));
+  return found ? found : end;
+}
+
+inline wchar_t const* FindStringTerminator(wchar_t const* beg,
+                                           wchar_t const* end)
+{
+  wchar_t const* const found =
+    std::wmemchr(beg, L'\0', static_cast<std::size_t>(end - beg));
+  return found ? found : end;
+}
+
+template <typename T> T const* FindStringTerminator(T const* beg, T const* end)
+{
+  return std::find(beg, end, T());
+}
+
+// Returns false if the string may continue past the small read (or the read
+// failed), in which case nothing has been written to the output.
+template <typename T, typename OutputIterator>
+bool ReadStringSmall(Process const& process,
+                     T* address,
+                     OutputIterator& data,
+                     void* upper_bound)
+{
+  auto const address_raw = reinterpret_cast<std::uintptr_t>(address);
+  std::size_t len_bytes = (std::min)(
+    kReadStringSmallLen,
+    kReadStringPageSize -
+      static_cast<std::size_t>(address_raw & (kReadStringPageSize - 1)));
+  bool at_bound = false;
+  if (upper_bound)
+  {
+    auto const upper_bound_raw = reinterpret_cast<std::uintptr_t>(upper_bound);
+    if (address_raw >= upper_bound_raw)
+    {
+      return true;
+    }
+
+    if (upper_bound_raw - address_raw <= len_bytes)
+    {
+      len_bytes = static_cast<std::size_t>(upper_bound_raw - address_raw);
+      at_bound = true;
+    }
+  }
+
+  // Unlike the normal path this doesn't go through a ProtectGuard, so only
+  // read regions which could be read without one. In particular a plain read
+  // of a guard page would trip its guard.
+  MEMORY_BASIC_INFORMATION const mbi = QueryCached(process, address);
+  if (IsBadProtect(mbi) || !CanRead(mbi))
+  {
+    return false;
+  }
+
+  std::size_t const len_to_region_end = static_cast<std::size_t>(
+    reinterpret_cast<std::uintptr_t>(mbi.BaseAddress) + mbi.RegionSize -
+    address_raw);
+  if (len_to_region_end < len_bytes)
+  {
+    len_bytes = len_to_region_end;
+    at_bound = false;
+  }
+
+  std::size_t const len = len_bytes / sizeof(T);
+  T buf[kReadStringSmallLen / sizeof(T)];
+  if (len && !TryReadUnchecked(process, address, buf, len * sizeof(T)))
+  {
+    return false;
+  }
+
+  T const* const end = buf + len;
+  T const* const iter = FindStringTerminator(buf, end);
+  if (iter == end && !at_bound)
+  {
+    return false;
+  }
+
+  data = std::copy(static_cast<T const*>(buf), iter, data);
+  return true;
+}
+
+// Reads a string a page at a time through the memory cache of the process
+// (the chunk length is irrelevant as whole pages are fetched anyway).
+template <typename T, typename OutputIterator>
+void ReadStringCached(Process const& process,
+                      RemoteMemoryCache const& cache,
+                      T* cur,
+                      OutputIterator data,
+                      void* upper_bound,
+                      std::vector<T>& buf)
+{
+  std::size_t const page_size = cache.GetPageSize();
+  if (buf.size() < page_size / sizeof(T) + 1)
+  {
+    buf.resize(page_size / sizeof(T) + 1);
+  }
+
+  for (;;)
+  {
+    auto const cur_raw = reinterpret_cast<std::uintptr_t>(cur);
+    std::size_t len_bytes =
+      page_size - static_cast<std::size_t>(cur_raw & (page_size - 1));
+    if (upper_bound)
+    {
+      auto const upper_bound_raw =
+        reinterpret_cast<std::uintptr_t>(upper_bound);
+      if (cur_raw >= upper_bound_raw ||
+          upper_bound_raw - cur_raw < sizeof(T))
+      {
+        return;
+      }
+
+      len_bytes = (std::min)(
+        len_bytes, static_cast<std::size_t>(upper_bound_raw - cur_raw));
+    }
+
+    // A character straddling a page boundary is read on its own.
+    std::size_t const len = (std::max)(len_bytes / sizeof(T),
+                                       static_cast<std::size_t>(1));
+    ReadImpl(process, cur, buf.data(), len * sizeof(T));
+
+    T const* const end = buf.data() + len;
+    T const* const iter = FindStringTerminator(buf.data(), end);
+    data = std::copy(static_cast<T const*>(buf.data()), iter, data);
+    if (iter != end)
+    {
+      return;
+    }
+
+    cur += len;
+  }
+}
 }
 
 template <typename T> inline T Read(Process const& process, PVOID address)
@@ -83,12 +233,16 @@ inline void
   std::copy(std::begin(data), std::end(data), out);
 }
 
+// buf is used as scratch space and may be reused between calls, in which
+// case reading a string does no allocation apart from what the output
+// iterator does.
 template <typename T, typename OutputIterator>
 void ReadStringEx(Process const& process,
                   PVOID address,
                   OutputIterator data,
                   std::size_t chunk_len,
-                  void* upper_bound)
+                  void* upper_bound,
+                  std::vector<T>& buf)
 {
   HADESMEM_DETAIL_STATIC_ASSERT(detail::IsCharType<T>::value);
   HADESMEM_DETAIL_STATIC_ASSERT(std::is_base_of<
@@ -97,12 +251,29 @@ void ReadStringEx(Process const& process,
 
   HADESMEM_DETAIL_ASSERT(chunk_len != 0);
 
-  for (;;)
+  if (RemoteMemoryCache const* const cache = process.GetMemoryCache())
   {
-    detail::ProtectGuard protect_guard{
-      process, address, detail::ProtectGuardType::kRead};
+    detail::ReadStringCached(
+      process, *cache, static_cast<T*>(address), data, upper_bound, buf);
+    return;
+  }
 
-    MEMORY_BASIC_INFORMATION const mbi = detail::Query(process, address);
+  if (detail::ReadStringSmall(
+        process, static_cast<T*>(address), data, upper_bound))
+  {
+    return;
+  }
+
+  if (buf.size() < chunk_len)
+  {
+    buf.resize(chunk_len);
+  }
+
+  for (;;)
+  {
+    bool from_cache = false;
+    MEMORY_BASIC_INFORMATION const mbi =
+      detail::QueryCached(process, address, &from_cache);
     PVOID const region_next_real =
       static_cast<PBYTE>(mbi.BaseAddress) + mbi.RegionSize;
     void* const region_next = upper_bound
@@ -110,33 +281,54 @@ void ReadStringEx(Process const& process,
                                 : region_next_real;
 
     T* cur = static_cast<T*>(address);
-    while (cur + 1 <= region_next)
+    bool written = false;
+    try
     {
-      std::size_t const len_to_end = reinterpret_cast<DWORD_PTR>(region_next) -
-                                     reinterpret_cast<DWORD_PTR>(cur);
-      std::size_t const buf_len_bytes =
-        (std::min)(chunk_len * sizeof(T), len_to_end);
-      std::size_t const buf_len = buf_len_bytes / sizeof(T);
-
-      std::vector<T> buf(buf_len);
-      detail::ReadUnchecked(process, cur, buf.data(), buf.size() * sizeof(T));
+      detail::ProtectGuard protect_guard{
+        process, mbi, detail::ProtectGuardType::kRead};
 
-      auto const iter = std::find(std::begin(buf), std::end(buf), T());
-      std::copy(std::begin(buf), iter, data);
+      while (cur + 1 <= region_next)
+      {
+        std::size_t const len_to_end =
+          reinterpret_cast<DWORD_PTR>(region_next) -
+          reinterpret_cast<DWORD_PTR>(cur);
+        std::size_t const buf_len_bytes =
+          (std::min)(chunk_len * sizeof(T), len_to_end);
+        std::size_t const buf_len = buf_len_bytes / sizeof(T);
+
+        detail::ReadUnchecked(process, cur, buf.data(), buf_len * sizeof(T));
+
+        T const* const end = buf.data() + buf_len;
+        T const* const iter = detail::FindStringTerminator(buf.data(), end);
+        written = true;
+        data = std::copy(static_cast<T const*>(buf.data()), iter, data);
+
+        if (iter != end || region_next == upper_bound)
+        {
+          protect_guard.Restore();
+          return;
+        }
+
+        cur += buf_len;
+      }
 
-      if (iter != std::end(buf) || region_next == upper_bound)
+      protect_guard.Restore();
+    }
+    catch (...)
+    {
+      // A stale cache entry can only be retried if nothing has been written
+      // to the output yet.
+      if (!from_cache || written)
       {
-        protect_guard.Restore();
-        return;
+        throw;
       }
 
-      cur += buf_len;
+      detail::InvalidateRegionCache(process, mbi.BaseAddress, mbi.RegionSize);
+      continue;
     }
 
     address = region_next;
 
-    protect_guard.Restore();
-
     if (upper_bound && cur >= upper_bound)
     {
       return;
@@ -144,6 +336,17 @@ void ReadStringEx(Process const& process,
   }
 }
 
+template <typename T, typename OutputIterator>
+void ReadStringEx(Process const& process,
+                  PVOID address,
+                  OutputIterator data,
+                  std::size_t chunk_len,
+                  void* upper_bound)
+{
+  std::vector<T> buf;
+  ReadStringEx<T>(process, address, data, chunk_len, upper_bound, buf);
+}
+
 template <typename T,
           typename Traits = std::char_traits<T>,
           typename Alloc = std::allocator<T>>
@@ -183,8 +386,11 @@ std::basic_string<T, Traits, Alloc>
 template <typename T, typename OutputIterator>
 void ReadString(Process const& process, PVOID address, OutputIterator data)
 {
-  return ReadStringEx<T>(
-    process, address, data, detail::ReadStringTraits<T>::kChunkLen);
+  return ReadStringEx<T>(process,
+                         address,
+                         data,
+                         detail::ReadStringTraits<T>::kChunkLen,
+                         nullptr);
 }
 
 template <typename T,
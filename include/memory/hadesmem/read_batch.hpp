@@ -0,0 +1,214 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <windows.h>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/read_batch_plan.hpp>
+#include <hadesmem/detail/read_impl.hpp>
+#include <hadesmem/detail/static_assert.hpp>
+#include <hadesmem/detail/type_traits.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/process.hpp>
+
+namespace hadesmem
+{
+namespace detail
+{
+// Reading a few unwanted bytes is much cheaper than another ReadProcessMemory
+// call, so requests this close together are merged.
+std::size_t const kReadBatchMaxGap = 0x100;
+
+std::size_t const kReadBatchMaxSpanSize = 0x10000;
+}
+
+// Collects many small reads and performs them with as few ReadProcessMemory
+// calls as possible. Requests are sorted, merged into spans (see
+// detail::PlanReadBatch) and each span is read into a buffer and scattered
+// back to the destinations. If a span cannot be read (e.g. because it crosses
+// into an inaccessible gap) its requests are retried individually, so each
+// request succeeds or fails exactly as it would with a separate Read. The
+// contents of the destination of a failed request are unspecified.
+class ReadBatch
+{
+public:
+  explicit ReadBatch(Process const& process,
+                     std::size_t max_gap = detail::kReadBatchMaxGap,
+                     std::size_t max_span_size = detail::kReadBatchMaxSpanSize)
+    : process_{&process},
+      max_gap_{max_gap},
+      max_span_size_{max_span_size},
+      num_reads_{0}
+  {
+  }
+
+  explicit ReadBatch(Process&& process,
+                     std::size_t max_gap = detail::kReadBatchMaxGap,
+                     std::size_t max_span_size =
+                       detail::kReadBatchMaxSpanSize) = delete;
+
+  // Returns the index of the request, for use with Succeeded.
+  std::size_t Add(PVOID address, void* data, std::size_t size)
+  {
+    HADESMEM_DETAIL_ASSERT(size ? address != nullptr : true);
+    HADESMEM_DETAIL_ASSERT(size ? data != nullptr : true);
+
+    Request const request = {address, data, size};
+    requests_.push_back(request);
+    return requests_.size() - 1;
+  }
+
+  template <typename T> std::size_t Add(PVOID address, T* data)
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+
+    return Add(address, static_cast<void*>(data), sizeof(T));
+  }
+
+  // Returns the number of requests which succeeded.
+  std::size_t Execute(std::uint32_t flags = ReadFlags::kNone)
+  {
+    std::vector<detail::ReadBatchRange> ranges;
+    ranges.reserve(requests_.size());
+    for (auto const& request : requests_)
+    {
+      detail::ReadBatchRange const range = {
+        reinterpret_cast<std::uintptr_t>(request.address), request.size};
+      ranges.push_back(range);
+    }
+
+    auto const plan =
+      detail::PlanReadBatch(ranges, max_gap_, max_span_size_);
+
+    succeeded_.assign(requests_.size(), false);
+    for (std::size_t i = 0; i < requests_.size(); ++i)
+    {
+      if (!requests_[i].size)
+      {
+        succeeded_[i] = true;
+      }
+    }
+
+    num_reads_ = 0;
+    for (auto const& span : plan.spans)
+    {
+      if (span.count == 1)
+      {
+        ReadRequest(plan.order[span.first], flags);
+        continue;
+      }
+
+      // Spans are read as is, without touching the protection of the pages
+      // they cover. Only the pages of the requests themselves are ever
+      // unprotected (by the retries below).
+      buffer_.resize(span.size);
+      ++num_reads_;
+      if (detail::TryReadUnchecked(*process_,
+                                   reinterpret_cast<PVOID>(span.address),
+                                   buffer_.data(),
+                                   span.size))
+      {
+        for (std::size_t i = span.first; i < span.first + span.count; ++i)
+        {
+          std::size_t const index = plan.order[i];
+          Request const& request = requests_[index];
+          std::size_t const offset = static_cast<std::size_t>(
+            reinterpret_cast<std::uintptr_t>(request.address) - span.address);
+          std::memcpy(request.data, buffer_.data() + offset, request.size);
+          succeeded_[index] = true;
+        }
+      }
+      else
+      {
+        for (std::size_t i = span.first; i < span.first + span.count; ++i)
+        {
+          ReadRequest(plan.order[i], flags);
+        }
+      }
+    }
+
+    std::size_t num_succeeded = 0;
+    for (auto const s : succeeded_)
+    {
+      if (s)
+      {
+        ++num_succeeded;
+      }
+    }
+
+    return num_succeeded;
+  }
+
+  bool Succeeded(std::size_t index) const
+  {
+    HADESMEM_DETAIL_ASSERT(index < succeeded_.size());
+    return succeeded_[index];
+  }
+
+  std::size_t GetNumRequests() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return requests_.size();
+  }
+
+  // Number of reads issued by the last call to Execute.
+  std::size_t GetNumReads() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return num_reads_;
+  }
+
+  void Clear() HADESMEM_DETAIL_NOEXCEPT
+  {
+    requests_.clear();
+    succeeded_.clear();
+    num_reads_ = 0;
+  }
+
+private:
+  struct Request
+  {
+    PVOID address;
+    void* data;
+    std::size_t size;
+  };
+
+  void ReadRequest(std::size_t index, std::uint32_t flags)
+  {
+    Request const& request = requests_[index];
+    ++num_reads_;
+    succeeded_[index] =
+      TryRead(request.address, request.data, request.size, flags);
+  }
+
+  bool
+    TryRead(PVOID address, void* data, std::size_t size, std::uint32_t flags)
+  {
+    try
+    {
+      detail::ReadImpl(*process_, address, data, size, flags);
+      return true;
+    }
+    catch (Error const&)
+    {
+      return false;
+    }
+  }
+
+  Process const* process_;
+  std::size_t max_gap_;
+  std::size_t max_span_size_;
+  std::vector<Request> requests_;
+  std::vector<bool> succeeded_;
+  std::vector<char> buffer_;
+  std::size_t num_reads_;
+};
+}
@@ -0,0 +1,295 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+
+namespace hadesmem
+{
+namespace detail
+{
+// Reads larger than this gain little from caching (they are rarely repeated
+// and would evict everything else), so they bypass the cache.
+std::size_t const kRemoteMemoryCacheMaxReadSize = 0x100000;
+}
+
+// Page-granular snapshot of remote memory. Once attached to a Process (see
+// Process::SetMemoryCache) every read through the normal read API (Read,
+// ReadVector, ReadString, etc.) is served from local copies of the pages
+// involved, which are fetched in full on first access. Pages stay valid until
+// Invalidate is called, or until they are older than max_age (if non-zero).
+// Writes made through hadesmem drop the affected pages, but changes made by
+// the target itself are not seen until the pages are invalidated or expire.
+// Pages which can't be read are remembered as such and reads touching them
+// go through the normal (uncached) path, so errors are reported as usual.
+// Reads larger than max_read_size also go through the normal path.
+class RemoteMemoryCache
+{
+public:
+  explicit RemoteMemoryCache(
+    std::size_t page_size = 0x1000,
+    std::chrono::milliseconds max_age = std::chrono::milliseconds(0),
+    std::size_t max_read_size = detail::kRemoteMemoryCacheMaxReadSize)
+    : page_size_{page_size},
+      max_age_(max_age),
+      max_read_size_{max_read_size},
+      epoch_{0},
+      synced_epoch_{0},
+      num_hits_{0},
+      num_misses_{0}
+  {
+    HADESMEM_DETAIL_ASSERT(page_size_ != 0);
+    HADESMEM_DETAIL_ASSERT((page_size_ & (page_size_ - 1)) == 0);
+  }
+
+  // Copies [address, address + len) to data, calling fetch(base, run_data,
+  // run_len) for runs of consecutive pages which aren't cached yet, so each
+  // run is fetched with a single read. fetch returns false if the run can't
+  // be read, in which case its pages are fetched one at a time. Returns false
+  // (without necessarily filling data) if any page involved can't be read,
+  // or if len is larger than the maximum read size.
+  template <typename FetchFunc>
+  bool Read(std::uintptr_t address,
+            void* data,
+            std::size_t len,
+            FetchFunc fetch)
+  {
+    if (len > max_read_size_)
+    {
+      return false;
+    }
+
+    auto out = static_cast<std::uint8_t*>(data);
+    while (len)
+    {
+      std::uintptr_t const page_base = address & ~(page_size_ - 1);
+      std::size_t const page_offset =
+        static_cast<std::size_t>(address - page_base);
+      std::size_t const chunk_len = (std::min)(len, page_size_ - page_offset);
+
+      PageLookup const lookup =
+        CopyFromPage(page_base, page_offset, out, chunk_len);
+      if (lookup == PageLookup::kUnreadable)
+      {
+        return false;
+      }
+
+      if (lookup == PageLookup::kHit)
+      {
+        address += chunk_len;
+        out += chunk_len;
+        len -= chunk_len;
+        continue;
+      }
+
+      std::size_t const num_pages =
+        (page_offset + len + page_size_ - 1) / page_size_;
+      std::size_t run_pages = CountMissingPages(page_base, num_pages);
+      std::vector<std::uint8_t> run(run_pages * page_size_);
+      bool valid = fetch(page_base, run.data(), run.size());
+      if (!valid && run_pages > 1)
+      {
+        run_pages = 1;
+        run.resize(page_size_);
+        valid = fetch(page_base, run.data(), run.size());
+      }
+
+      InsertPages(page_base, run, run_pages, valid);
+      if (!valid)
+      {
+        return false;
+      }
+
+      std::size_t const copy_len = (std::min)(len, run.size() - page_offset);
+      std::memcpy(out, run.data() + page_offset, copy_len);
+      address += copy_len;
+      out += copy_len;
+      len -= copy_len;
+    }
+
+    return true;
+  }
+
+  void Invalidate() HADESMEM_DETAIL_NOEXCEPT
+  {
+    ++epoch_;
+  }
+
+  // Drops every page overlapping [address, address + size).
+  void InvalidateRange(std::uintptr_t address, std::size_t size)
+  {
+    if (!size)
+    {
+      return;
+    }
+
+    std::uintptr_t const first = address & ~(page_size_ - 1);
+    std::uintptr_t const max_address =
+      (std::numeric_limits<std::uintptr_t>::max)();
+    std::uintptr_t const last =
+      size - 1 > max_address - address ? max_address : address + (size - 1);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    SyncEpoch();
+    pages_.erase(pages_.lower_bound(first), pages_.upper_bound(last));
+  }
+
+  std::size_t GetPageSize() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return page_size_;
+  }
+
+  std::size_t GetMaxReadSize() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return max_read_size_;
+  }
+
+  std::size_t GetNumPages()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SyncEpoch();
+    return pages_.size();
+  }
+
+  std::uint64_t GetNumHits() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return num_hits_;
+  }
+
+  std::uint64_t GetNumMisses() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return num_misses_;
+  }
+
+private:
+  enum class PageLookup
+  {
+    kHit,
+    kMiss,
+    kUnreadable
+  };
+
+  struct Page
+  {
+    std::vector<std::uint8_t> data;
+    std::chrono::steady_clock::time_point time;
+    bool valid;
+  };
+
+  PageLookup CopyFromPage(std::uintptr_t page_base,
+                          std::size_t page_offset,
+                          std::uint8_t* out,
+                          std::size_t len)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SyncEpoch();
+
+    auto const iter = pages_.find(page_base);
+    if (iter == std::end(pages_) || IsExpired(iter->second))
+    {
+      ++num_misses_;
+      return PageLookup::kMiss;
+    }
+
+    if (!iter->second.valid)
+    {
+      return PageLookup::kUnreadable;
+    }
+
+    ++num_hits_;
+    std::memcpy(out, iter->second.data.data() + page_offset, len);
+    return PageLookup::kHit;
+  }
+
+  // Returns the number of consecutive pages starting at page_base (which is
+  // already known to be missing) and up to max_pages which aren't cached.
+  std::size_t CountMissingPages(std::uintptr_t page_base,
+                                std::size_t max_pages)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SyncEpoch();
+
+    std::size_t num_pages = 1;
+    for (; num_pages < max_pages; ++num_pages)
+    {
+      auto const iter = pages_.find(page_base + num_pages * page_size_);
+      if (iter != std::end(pages_) && !IsExpired(iter->second))
+      {
+        break;
+      }
+    }
+
+    num_misses_ += num_pages - 1;
+    return num_pages;
+  }
+
+  // Only the first page is marked as unreadable if the run is invalid, as
+  // runs which can't be read are always retried a page at a time.
+  void InsertPages(std::uintptr_t page_base,
+                   std::vector<std::uint8_t> const& run,
+                   std::size_t num_pages,
+                   bool valid)
+  {
+    auto const time = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    SyncEpoch();
+    for (std::size_t i = 0; i < num_pages; ++i)
+    {
+      Page& page = pages_[page_base + i * page_size_];
+      if (valid)
+      {
+        auto const page_beg = run.data() + i * page_size_;
+        page.data.assign(page_beg, page_beg + page_size_);
+      }
+      else
+      {
+        page.data.clear();
+      }
+
+      page.time = time;
+      page.valid = valid;
+    }
+  }
+
+  bool IsExpired(Page const& page) const
+  {
+    return max_age_.count() &&
+           std::chrono::steady_clock::now() - page.time > max_age_;
+  }
+
+  void SyncEpoch()
+  {
+    std::uint32_t const epoch = epoch_;
+    if (epoch != synced_epoch_)
+    {
+      pages_.clear();
+      synced_epoch_ = epoch;
+    }
+  }
+
+  std::size_t page_size_;
+  std::chrono::milliseconds max_age_;
+  std::size_t max_read_size_;
+  std::mutex mutex_;
+  std::map<std::uintptr_t, Page> pages_;
+  std::atomic<std::uint32_t> epoch_;
+  std::uint32_t synced_epoch_;
+  std::atomic<std::uint64_t> num_hits_;
+  std::atomic<std::uint64_t> num_misses_;
+};
+}
@@ -0,0 +1,249 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include <windows.h>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/protect_guard.hpp>
+#include <hadesmem/detail/query_region.hpp>
+#include <hadesmem/detail/read_batch_plan.hpp>
+#include <hadesmem/detail/read_impl.hpp>
+#include <hadesmem/detail/static_assert.hpp>
+#include <hadesmem/detail/trace.hpp>
+#include <hadesmem/detail/type_traits.hpp>
+#include <hadesmem/detail/write_impl.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/flush.hpp>
+#include <hadesmem/process.hpp>
+
+namespace hadesmem
+{
+// Collects many writes and applies them together. On commit, overlapping and
+// adjacent writes are merged (later writes win where they overlap), the
+// resulting ranges are grouped by region and each region has its protection
+// changed (if necessary) and restored only once, rather than once per write.
+// The instruction cache is flushed once at the end.
+// If any write fails, the bytes already written by the commit are restored
+// to their original values (as far as possible) before the error is
+// propagated.
+class WriteTransaction
+{
+public:
+  explicit WriteTransaction(Process const& process)
+    : process_{&process}, num_regions_{0}, num_writes_{0}
+  {
+  }
+
+  explicit WriteTransaction(Process&& process) = delete;
+
+  // The data is copied, so it need not outlive the call.
+  void Add(PVOID address, LPCVOID data, std::size_t size)
+  {
+    HADESMEM_DETAIL_ASSERT(size ? address != nullptr : true);
+    HADESMEM_DETAIL_ASSERT(size ? data != nullptr : true);
+
+    Request const request = {address, data_.size(), size};
+    auto const data_beg = static_cast<std::uint8_t const*>(data);
+    data_.insert(std::end(data_), data_beg, data_beg + size);
+    requests_.push_back(request);
+  }
+
+  template <typename T> void Add(PVOID address, T const& data)
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+
+    Add(address, std::addressof(data), sizeof(data));
+  }
+
+  void Commit()
+  {
+    std::vector<Patch> patches = BuildPatches();
+
+    num_regions_ = 0;
+    num_writes_ = 0;
+
+    std::vector<Patch> applied;
+    try
+    {
+      std::size_t i = 0;
+      std::size_t offset = 0;
+      while (i < patches.size())
+      {
+        std::uint8_t* const address = patches[i].address + offset;
+        MEMORY_BASIC_INFORMATION const mbi = detail::Query(*process_, address);
+        std::uintptr_t const region_end =
+          reinterpret_cast<std::uintptr_t>(mbi.BaseAddress) + mbi.RegionSize;
+
+        ++num_regions_;
+        detail::ProtectGuard protect_guard{
+          *process_, mbi, detail::ProtectGuardType::kWrite};
+
+        while (i < patches.size() &&
+               reinterpret_cast<std::uintptr_t>(patches[i].address + offset) <
+                 region_end)
+        {
+          Patch const& patch = patches[i];
+          std::uint8_t* const cur = patch.address + offset;
+          std::size_t const len = static_cast<std::size_t>((std::min)(
+            static_cast<std::uintptr_t>(patch.data.size() - offset),
+            region_end - reinterpret_cast<std::uintptr_t>(cur)));
+
+          Patch original;
+          original.address = cur;
+          original.data.resize(len);
+          detail::ReadUnchecked(*process_, cur, original.data.data(), len);
+          applied.push_back(std::move(original));
+
+          detail::InvalidateMemoryCache(*process_, cur, len);
+          ++num_writes_;
+          detail::WriteUnchecked(
+            *process_, cur, patch.data.data() + offset, len);
+
+          offset += len;
+          if (offset == patch.data.size())
+          {
+            ++i;
+            offset = 0;
+          }
+        }
+
+        protect_guard.Restore();
+      }
+    }
+    catch (...)
+    {
+      Rollback(applied);
+      throw;
+    }
+
+    if (!patches.empty())
+    {
+      std::uint8_t* const first = patches.front().address;
+      std::uint8_t* const last =
+        patches.back().address + patches.back().data.size();
+      FlushInstructionCache(
+        *process_, first, static_cast<SIZE_T>(last - first));
+    }
+  }
+
+  std::size_t GetNumRequests() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return requests_.size();
+  }
+
+  // Number of regions touched by the last call to Commit. Protection is
+  // changed at most once per region.
+  std::size_t GetNumRegions() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return num_regions_;
+  }
+
+  // Number of writes issued by the last call to Commit.
+  std::size_t GetNumWrites() const HADESMEM_DETAIL_NOEXCEPT
+  {
+    return num_writes_;
+  }
+
+  void Clear() HADESMEM_DETAIL_NOEXCEPT
+  {
+    requests_.clear();
+    data_.clear();
+    num_regions_ = 0;
+    num_writes_ = 0;
+  }
+
+private:
+  struct Request
+  {
+    PVOID address;
+    std::size_t offset;
+    std::size_t size;
+  };
+
+  struct Patch
+  {
+    std::uint8_t* address;
+    std::vector<std::uint8_t> data;
+  };
+
+  std::vector<Patch> BuildPatches() const
+  {
+    std::vector<detail::ReadBatchRange> ranges;
+    ranges.reserve(requests_.size());
+    for (auto const& request : requests_)
+    {
+      detail::ReadBatchRange const range = {
+        reinterpret_cast<std::uintptr_t>(request.address), request.size};
+      ranges.push_back(range);
+    }
+
+    // With no gap allowed every span is fully covered by its requests.
+    auto const plan = detail::PlanReadBatch(ranges, 0, 0);
+
+    std::vector<Patch> patches(plan.spans.size());
+    std::vector<std::size_t> patch_index(requests_.size());
+    for (std::size_t i = 0; i < plan.spans.size(); ++i)
+    {
+      auto const& span = plan.spans[i];
+      patches[i].address = reinterpret_cast<std::uint8_t*>(span.address);
+      patches[i].data.resize(span.size);
+      for (std::size_t j = span.first; j < span.first + span.count; ++j)
+      {
+        patch_index[plan.order[j]] = i;
+      }
+    }
+
+    // Apply in the order the writes were added so later writes win.
+    for (std::size_t i = 0; i < requests_.size(); ++i)
+    {
+      Request const& request = requests_[i];
+      if (!request.size)
+      {
+        continue;
+      }
+
+      Patch& patch = patches[patch_index[i]];
+      std::size_t const offset = static_cast<std::size_t>(
+        static_cast<std::uint8_t*>(request.address) - patch.address);
+      std::memcpy(&patch.data[offset], &data_[request.offset], request.size);
+    }
+
+    return patches;
+  }
+
+  void Rollback(std::vector<Patch> const& applied) HADESMEM_DETAIL_NOEXCEPT
+  {
+    for (auto iter = applied.rbegin(); iter != applied.rend(); ++iter)
+    {
+      try
+      {
+        detail::WriteImpl(
+          *process_, iter->address, iter->data.data(), iter->data.size());
+      }
+      catch (...)
+      {
+        // WARNING: Original bytes are not restored if the write fails.
+        HADESMEM_DETAIL_TRACE_A(
+          boost::current_exception_diagnostic_information().c_str());
+      }
+    }
+  }
+
+  Process const* process_;
+  std::vector<Request> requests_;
+  std::vector<std::uint8_t> data_;
+  std::size_t num_regions_;
+  std::size_t num_writes_;
+};
+}
@@ -0,0 +1,109 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#include <hadesmem/fast_accessor.hpp>
+#include <hadesmem/fast_accessor.hpp>
+
+#include <memory>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/winapi.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/read.hpp>
+#include <hadesmem/remote_memory_cache.hpp>
+
+void TestFastAccessorAccessible()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+  hadesmem::FastAccessor accessor(process);
+
+  int value = 0x1337;
+  BOOST_TEST_EQ(accessor.Read<int>(&value), 0x1337);
+  accessor.Write(&value, 0x7331);
+  BOOST_TEST_EQ(value, 0x7331);
+
+  std::vector<int> int_list = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  BOOST_TEST(accessor.ReadVector<int>(&int_list[0], 10) == int_list);
+  BOOST_TEST(accessor.ReadVector<int>(&int_list[0], 0).empty());
+
+  BOOST_TEST_EQ(accessor.GetNumAccesses(), 3ULL);
+  BOOST_TEST_EQ(accessor.GetNumFallbacks(), 0ULL);
+
+  accessor.ResetCounts();
+  BOOST_TEST_EQ(accessor.GetNumAccesses(), 0ULL);
+}
+
+void TestFastAccessorFallback()
+{
+  SYSTEM_INFO const sys_info = hadesmem::detail::GetSystemInfo();
+  DWORD const page_size = sys_info.dwPageSize;
+
+  PVOID const address = VirtualAlloc(
+    nullptr, page_size * 2, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+  BOOST_TEST(address != 0);
+  static_cast<int*>(address)[0] = 0x1337;
+  DWORD old_protect = 0;
+#pragma warning(suppress : 6387)
+  BOOST_TEST(VirtualProtect(address, page_size, PAGE_NOACCESS, &old_protect) !=
+             0);
+
+  hadesmem::Process const process(::GetCurrentProcessId());
+  hadesmem::FastAccessor accessor(process);
+  BOOST_TEST_EQ(accessor.Read<int>(address), 0x1337);
+  BOOST_TEST_EQ(accessor.GetNumFallbacks(), 1ULL);
+
+  std::vector<char> buf(page_size * 2, 'h');
+  accessor.Write(address, buf.data(), buf.size());
+  BOOST_TEST_EQ(accessor.GetNumFallbacks(), 2ULL);
+  BOOST_TEST(hadesmem::ReadVector<char>(process, address, buf.size()) == buf);
+
+  std::vector<char> buf_fast = hadesmem::ReadVectorEx<char>(
+    process, address, buf.size(), hadesmem::ReadFlags::kAssumeAccessible);
+  BOOST_TEST(buf_fast == buf);
+
+  BOOST_TEST(VirtualProtect(
+               address, page_size * 2, PAGE_READWRITE, &old_protect) != 0);
+  BOOST_TEST(accessor.ReadVector<char>(address, buf.size()) == buf);
+  BOOST_TEST_EQ(accessor.GetNumAccesses(), 3ULL);
+  BOOST_TEST_EQ(accessor.GetNumFallbacks(), 2ULL);
+}
+
+void TestFastAccessorCachedFallback()
+{
+  SYSTEM_INFO const sys_info = hadesmem::detail::GetSystemInfo();
+  DWORD const page_size = sys_info.dwPageSize;
+
+  PVOID const address =
+    VirtualAlloc(nullptr, page_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+  BOOST_TEST(address != 0);
+  static_cast<int*>(address)[0] = 0x1337;
+  DWORD old_protect = 0;
+#pragma warning(suppress : 6387)
+  BOOST_TEST(VirtualProtect(address, page_size, PAGE_NOACCESS, &old_protect) !=
+             0);
+
+  hadesmem::Process process(::GetCurrentProcessId());
+  process.SetMemoryCache(
+    std::make_shared<hadesmem::RemoteMemoryCache>(page_size));
+  hadesmem::FastAccessor accessor(process);
+  BOOST_TEST_EQ(accessor.Read<int>(address), 0x1337);
+  BOOST_TEST_EQ(accessor.GetNumFallbacks(), 1ULL);
+  BOOST_TEST_EQ(accessor.Read<int>(address), 0x1337);
+  BOOST_TEST_EQ(accessor.GetNumFallbacks(), 1ULL);
+
+  BOOST_TEST(VirtualFree(address, 0, MEM_RELEASE) != 0);
+}
+
+int main()
+{
+  TestFastAccessorAccessible();
+  TestFastAccessorFallback();
+  TestFastAccessorCachedFallback();
+  return boost::report_errors();
+}
@@ -4,6 +4,11 @@
 #include <hadesmem/find_pattern.hpp>
 #include <hadesmem/find_pattern.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include <hadesmem/detail/warning_disable_prefix.hpp>
 #include <boost/detail/lightweight_test.hpp>
 #include <hadesmem/detail/warning_disable_suffix.hpp>
@@ -33,6 +38,35 @@ void TestFindPattern()
                          0U);
   BOOST_TEST_NE(nop_file, static_cast<void*>(nullptr));
 
+  void* nop_pe_file =
+    hadesmem::FindInPeFile(process,
+                           hadesmem::detail::GetSelfPath(),
+                           L"90",
+                           hadesmem::PatternFlags::kRelativeAddress,
+                           0U);
+  BOOST_TEST_NE(nop_pe_file, static_cast<void*>(nullptr));
+  BOOST_TEST(nop_pe_file >= nop_file);
+
+  std::uint8_t const buffer[] = {0x00, 0x90, 0x11, 0x90};
+  BOOST_TEST_EQ(hadesmem::FindInBuffer(buffer,
+                                       sizeof(buffer),
+                                       L"90",
+                                       hadesmem::PatternFlags::kRelativeAddress,
+                                       0U),
+                reinterpret_cast<void*>(1));
+  BOOST_TEST_EQ(hadesmem::FindInBuffer(buffer,
+                                       sizeof(buffer),
+                                       L"90",
+                                       hadesmem::PatternFlags::kRelativeAddress,
+                                       1U),
+                reinterpret_cast<void*>(3));
+  BOOST_TEST_EQ(hadesmem::FindInBuffer(buffer,
+                                       sizeof(buffer),
+                                       L"90 90",
+                                       hadesmem::PatternFlags::kNone,
+                                       0U),
+                static_cast<void*>(nullptr));
+
   void* nop_second =
     hadesmem::Find(process,
                    L"",
@@ -44,6 +78,113 @@ void TestFindPattern()
   BOOST_TEST(nop_second > nop);
   BOOST_TEST(nop_second > reinterpret_cast<void*>(process_base));
 
+  hadesmem::CompiledPattern const nop_compiled{L"90"};
+  BOOST_TEST_EQ(nop_compiled.GetSize(), 1UL);
+  BOOST_TEST_EQ(nop_compiled.GetAnchorOffset(), 0UL);
+  BOOST_TEST_EQ(hadesmem::Find(process,
+                               L"",
+                               nop_compiled,
+                               hadesmem::PatternFlags::kNone,
+                               0U),
+                nop);
+  BOOST_TEST_EQ(
+    hadesmem::Find(process,
+                   L"",
+                   nop_compiled,
+                   hadesmem::PatternFlags::kNone,
+                   reinterpret_cast<std::uintptr_t>(nop) - process_base),
+    nop_second);
+  BOOST_TEST_EQ(
+    hadesmem::Find(process,
+                   L"",
+                   nop_compiled,
+                   hadesmem::PatternFlags::kParallel,
+                   reinterpret_cast<std::uintptr_t>(nop) - process_base),
+    nop_second);
+
+  std::vector<void*> nops;
+  auto const all_nops = hadesmem::FindAll(
+    process, L"", nop_compiled, hadesmem::PatternFlags::kNone);
+  for (auto const address : all_nops)
+  {
+    nops.push_back(address);
+  }
+  BOOST_TEST(nops.size() >= 2);
+  BOOST_TEST(std::is_sorted(std::begin(nops), std::end(nops)));
+  BOOST_TEST_EQ(nops[0], nop);
+  BOOST_TEST_EQ(nops[1], nop_second);
+
+  auto const nops_rel = hadesmem::FindAll(
+    process, L"", L"90", hadesmem::PatternFlags::kRelativeAddress, 2);
+  BOOST_TEST_EQ(std::distance(std::begin(nops_rel), std::end(nops_rel)), 2);
+  BOOST_TEST_EQ(*std::begin(nops_rel),
+                static_cast<void*>(static_cast<std::uint8_t*>(nop) -
+                                   process_base));
+
+  // Large enough to be split across threads, with one match straddling the
+  // boundary between the first two chunks.
+  std::vector<std::uint8_t> big_buf(9 * 1024 * 1024);
+  std::uint8_t const marker[] = {0xDE, 0xAD, 0xBE, 0xEF};
+  std::size_t const marker_offsets[] = {
+    0x10, 4 * 1024 * 1024 - 2, big_buf.size() - sizeof(marker)};
+  for (auto const offset : marker_offsets)
+  {
+    std::copy(std::begin(marker), std::end(marker), &big_buf[offset]);
+  }
+  std::uint32_t const parallel_flags =
+    hadesmem::PatternFlags::kParallel |
+    hadesmem::PatternFlags::kRelativeAddress;
+  auto const markers = hadesmem::FindAll(process,
+                                         big_buf.data(),
+                                         big_buf.size(),
+                                         L"DE AD BE EF",
+                                         parallel_flags);
+  std::vector<void*> const marker_matches(std::begin(markers),
+                                          std::end(markers));
+  BOOST_TEST_EQ(marker_matches.size(), 3UL);
+  for (std::size_t i = 0; i < marker_matches.size() && i < 3; ++i)
+  {
+    BOOST_TEST_EQ(marker_matches[i],
+                  reinterpret_cast<void*>(marker_offsets[i]));
+  }
+
+  std::wstring const unmatched_name{L"Unmatched"};
+  auto const unmatched =
+    hadesmem::FindAll(process,
+                      L"",
+                      L"DE AD BE EF DE AD BE EF DE AD BE EF",
+                      hadesmem::PatternFlags::kThrowOnUnmatch,
+                      0,
+                      &unmatched_name);
+  BOOST_TEST_THROWS(std::begin(unmatched), hadesmem::Error);
+
+  hadesmem::CompiledPattern const nop_static{hadesmem::StaticPattern<0x90>{}};
+  BOOST_TEST_EQ(nop_static.GetSize(), 1UL);
+  BOOST_TEST_EQ(hadesmem::Find(process,
+                               L"",
+                               hadesmem::StaticPattern<0x90>{},
+                               hadesmem::PatternFlags::kNone,
+                               0U),
+                nop);
+
+  typedef hadesmem::StaticPattern<0x8D,
+                                  0x8D,
+                                  0x40,
+                                  hadesmem::PatternByte::kWildcard,
+                                  0xFF> StaticTestPattern;
+  hadesmem::CompiledPattern const static_compiled{StaticTestPattern{}};
+  hadesmem::CompiledPattern const dynamic_compiled{L"8D 8D 40 ?? FF"};
+  BOOST_TEST_EQ(static_compiled.GetSize(), dynamic_compiled.GetSize());
+  for (std::size_t i = 0; i < static_compiled.GetSize(); ++i)
+  {
+    BOOST_TEST_EQ(static_compiled.GetData()[i].data,
+                  dynamic_compiled.GetData()[i].data);
+    BOOST_TEST_EQ(static_compiled.GetData()[i].wildcard,
+                  dynamic_compiled.GetData()[i].wildcard);
+  }
+  BOOST_TEST_EQ(static_compiled.GetAnchorOffset(),
+                dynamic_compiled.GetAnchorOffset());
+
   void* find_pattern_string =
     hadesmem::Find(process,
                    L"",
@@ -128,6 +269,28 @@ void TestFindPattern()
   BOOST_TEST_EQ(find_pattern.GetModuleMap().size(), 2UL);
   BOOST_TEST_EQ(find_pattern.GetPatternMap(L"").size(), 5UL);
 
+  std::wstring const cache_path =
+    hadesmem::detail::GetSelfDirPath() + L"\\find_pattern_cache.bin";
+  ::DeleteFileW(cache_path.c_str());
+  hadesmem::FindPattern const find_pattern_uncached{
+    process, pattern_file_data, true, cache_path};
+  BOOST_TEST(find_pattern_uncached == find_pattern);
+  BOOST_TEST(hadesmem::detail::DoesFileExist(cache_path));
+  hadesmem::FindPattern const find_pattern_cached{
+    process, pattern_file_data, true, cache_path};
+  BOOST_TEST(find_pattern_cached == find_pattern);
+  ::DeleteFileW(cache_path.c_str());
+
+  hadesmem::FindPattern find_pattern_lazy{
+    process, pattern_file_data, true, hadesmem::FindPatternFlags::kLazy};
+  BOOST_TEST_EQ(find_pattern_lazy.GetModuleMap().size(), 0UL);
+  BOOST_TEST_EQ(find_pattern_lazy.Lookup(L"", L"Nop Other"),
+                find_pattern.Lookup(L"", L"Nop Other"));
+  BOOST_TEST_EQ(find_pattern_lazy.GetModuleMap().size(), 1UL);
+  find_pattern_lazy.ResolveModule(L"NtDll.dll");
+  BOOST_TEST_EQ(find_pattern_lazy.GetModuleMap().size(), 2UL);
+  BOOST_TEST(find_pattern_lazy == find_pattern);
+
   BOOST_TEST_NE(find_pattern.Lookup(L"", L"First Call"),
                 static_cast<void*>(nullptr));
   BOOST_TEST_NE(find_pattern.Lookup(L"", L"Zeros New"),
@@ -259,8 +422,152 @@ void TestFindPattern()
     hadesmem::Error);
 }
 
+void TestPatternCache()
+{
+  hadesmem::detail::PatternCache cache;
+  hadesmem::detail::PatternCache::ModuleId const id = {1, 2, 3};
+  hadesmem::detail::PatternCache::ModuleId const id_new = {1, 2, 4};
+  cache.Insert(L"FOO.DLL", id, 0x1234, {0x5678, true});
+  cache.Insert(L"", id, 0x4321, {0, false});
+  BOOST_TEST(cache.IsDirty());
+
+  hadesmem::detail::PatternCache cache_copy;
+  BOOST_TEST(cache_copy.Deserialize(cache.Serialize()));
+  BOOST_TEST(!cache_copy.IsDirty());
+  auto const entry = cache_copy.Lookup(L"FOO.DLL", id, 0x1234);
+  BOOST_TEST(entry != nullptr);
+  BOOST_TEST_EQ(entry->value, 0x5678ULL);
+  BOOST_TEST(entry->matched);
+  auto const entry_unmatched = cache_copy.Lookup(L"", id, 0x4321);
+  BOOST_TEST(entry_unmatched != nullptr);
+  BOOST_TEST(!entry_unmatched->matched);
+  BOOST_TEST(cache_copy.Lookup(L"FOO.DLL", id, 0x4321) == nullptr);
+  BOOST_TEST(cache_copy.Lookup(L"FOO.DLL", id_new, 0x1234) == nullptr);
+
+  cache_copy.Insert(L"FOO.DLL", id_new, 0x1111, {0x2222, true});
+  BOOST_TEST(cache_copy.Lookup(L"FOO.DLL", id, 0x1234) == nullptr);
+  BOOST_TEST(cache_copy.Lookup(L"FOO.DLL", id_new, 0x1111) != nullptr);
+
+  auto truncated = cache.Serialize();
+  truncated.pop_back();
+  BOOST_TEST(!cache_copy.Deserialize(truncated));
+  BOOST_TEST(cache_copy.Lookup(L"", id, 0x4321) == nullptr);
+}
+
+void TestMultiPatternMatcher()
+{
+  std::uint8_t const haystack[] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55,
+                                   0x11, 0x22, 0x99, 0x44, 0xE8, 0x90};
+  auto const h_beg = &haystack[0];
+  auto const h_end = &haystack[0] + sizeof(haystack);
+
+  auto const needle_pair = hadesmem::detail::ConvertData(L"11 22 ?? 44");
+  auto const needle_single = hadesmem::detail::ConvertData(L"?? E8");
+  auto const needle_wildcard = hadesmem::detail::ConvertData(L"?? ??");
+  auto const needle_missing = hadesmem::detail::ConvertData(L"44 55 66");
+  auto const needle_too_long =
+    hadesmem::detail::ConvertData(L"E8 90 ?? ?? ?? ??");
+
+  hadesmem::detail::MultiPatternMatcher matcher;
+  matcher.Add(needle_pair.data(), needle_pair.data() + needle_pair.size());
+  matcher.Add(needle_pair.data(), needle_pair.data() + needle_pair.size(), 2);
+  matcher.Add(
+    needle_single.data(), needle_single.data() + needle_single.size());
+  matcher.Add(
+    needle_wildcard.data(), needle_wildcard.data() + needle_wildcard.size(), 5);
+  matcher.Add(
+    needle_missing.data(), needle_missing.data() + needle_missing.size());
+  matcher.Add(
+    needle_too_long.data(), needle_too_long.data() + needle_too_long.size());
+  BOOST_TEST_EQ(matcher.GetSize(), 6UL);
+
+  auto const results = matcher.Search(h_beg, h_end);
+  BOOST_TEST_EQ(results.size(), 6UL);
+  BOOST_TEST_EQ(results[0], 1UL);
+  BOOST_TEST_EQ(results[1], 6UL);
+  BOOST_TEST_EQ(results[2], 9UL);
+  BOOST_TEST_EQ(results[3], 5UL);
+  BOOST_TEST(results[4] == hadesmem::detail::MultiPatternMatcher::kNoMatch);
+  BOOST_TEST(results[5] == hadesmem::detail::MultiPatternMatcher::kNoMatch);
+}
+
+void TestPatternSearcher()
+{
+  // Deterministic pseudo-random haystack with a small alphabet so that partial
+  // matches (and therefore candidate verification) are common.
+  std::vector<std::uint8_t> haystack(0x1000);
+  std::uint32_t seed = 0x12345678;
+  for (auto& b : haystack)
+  {
+    seed = seed * 1103515245 + 12345;
+    b = static_cast<std::uint8_t>((seed >> 16) % 3);
+  }
+
+  std::wstring const patterns[] = {L"00",
+                                   L"02 ??",
+                                   L"?? 01 02 00",
+                                   L"01 ?? ?? 02 00 01 ?? 02 00 01",
+                                   L"02 02 02 02 02 02 02 02 02",
+                                   L"?? ?? ??",
+                                   L"FF"};
+  auto const h_beg = haystack.data();
+  auto const h_end = haystack.data() + haystack.size();
+  for (auto const& pattern : patterns)
+  {
+    auto const needle = hadesmem::detail::ConvertData(pattern);
+    auto const expected = std::search(
+      h_beg,
+      h_end,
+      std::begin(needle),
+      std::end(needle),
+      [](std::uint8_t h_cur, hadesmem::detail::PatternDataByte const& n_cur)
+      {
+      return n_cur.wildcard || h_cur == n_cur.data;
+    });
+    void const* const expected_ptr = expected == h_end ? nullptr : expected;
+
+    hadesmem::detail::PatternSearcher const searcher{std::begin(needle),
+                                                     std::end(needle)};
+    BOOST_TEST_EQ(static_cast<void const*>(searcher.Search(h_beg, h_end)),
+                  expected_ptr);
+    BOOST_TEST_EQ(static_cast<void const*>(searcher.SearchScalar(h_beg, h_end)),
+                  expected_ptr);
+    BOOST_TEST_EQ(
+      static_cast<void const*>(searcher.SearchHorspool(h_beg, h_end)),
+      expected_ptr);
+#if defined(HADESMEM_DETAIL_PATTERN_SSE2)
+    BOOST_TEST_EQ(static_cast<void const*>(searcher.SearchSse2(h_beg, h_end)),
+                  expected_ptr);
+#endif
+#if defined(HADESMEM_DETAIL_PATTERN_AVX2)
+    BOOST_TEST_EQ(static_cast<void const*>(searcher.SearchAvx2(h_beg, h_end)),
+                  expected_ptr);
+#endif
+
+    std::size_t const size = haystack.size();
+    for (std::size_t const chunk_size : {1, 7, 0x100, 0x2000})
+    {
+      std::size_t const match = hadesmem::detail::ParallelScan(
+        size,
+        chunk_size,
+        needle.size() - 1,
+        4,
+        [&](std::size_t offset, std::size_t length)
+        {
+          auto const found =
+            searcher.Search(h_beg + offset, h_beg + offset + length);
+          return found ? static_cast<std::size_t>(found - h_beg) : size;
+        });
+      BOOST_TEST_EQ(match, static_cast<std::size_t>(expected - h_beg));
+    }
+  }
+}
+
 int main()
 {
   TestFindPattern();
+  TestPatternCache();
+  TestMultiPatternMatcher();
+  TestPatternSearcher();
   return boost::report_errors();
 }
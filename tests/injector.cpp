@@ -12,6 +12,7 @@
 #include <hadesmem/config.hpp>
 #include <hadesmem/detail/self_path.hpp>
 #include <hadesmem/error.hpp>
+#include <hadesmem/procedure_resolver.hpp>
 #include <hadesmem/process.hpp>
 
 void TestInjector()
@@ -90,8 +91,31 @@ void TestInjector()
   }
 }
 
+void TestInjectorResolver()
+{
+  hadesmem::Process const process{::GetCurrentProcessId()};
+
+  HMODULE const kernel32_mod = ::GetModuleHandleW(L"kernel32.dll");
+  BOOST_TEST_NE(kernel32_mod, static_cast<HMODULE>(nullptr));
+
+  // Share the export lookups between the inject, call and free.
+  hadesmem::ProcedureResolver resolver{process};
+  HMODULE const kernel32_mod_new = hadesmem::InjectDll(
+    process, L"kernel32.dll", hadesmem::InjectFlags::kNone, resolver);
+  BOOST_TEST_EQ(kernel32_mod, kernel32_mod_new);
+
+  SetLastError(0);
+  auto const export_ret = CallExport(
+    process, kernel32_mod_new, "GetCurrentProcessId", resolver);
+  BOOST_TEST_EQ(export_ret.GetReturnValue(), GetCurrentProcessId());
+  BOOST_TEST_EQ(export_ret.GetLastError(), 0UL);
+
+  hadesmem::FreeDll(process, kernel32_mod_new, resolver);
+}
+
 int main()
 {
   TestInjector();
+  TestInjectorResolver();
   return boost::report_errors();
 }
@@ -0,0 +1,135 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#include <hadesmem/memory_backend.hpp>
+#include <hadesmem/memory_backend.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/buffer_memory_backend.hpp>
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/local_memory_backend.hpp>
+#include <hadesmem/pelib/dos_header.hpp>
+#include <hadesmem/pelib/nt_headers.hpp>
+#include <hadesmem/pelib/pe_file.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/protect.hpp>
+#include <hadesmem/read.hpp>
+#include <hadesmem/region_list.hpp>
+#include <hadesmem/write.hpp>
+
+void TestBufferMemoryBackend()
+{
+  hadesmem::Process process(::GetCurrentProcessId());
+  auto const base = reinterpret_cast<std::uint8_t*>(0x10000000);
+  std::vector<std::uint8_t> buf(0x2000);
+  std::strcpy(reinterpret_cast<char*>(&buf[0x100]), "Hello World!");
+  auto const backend =
+    std::make_shared<hadesmem::BufferMemoryBackend>(base, buf.data(), 0x2000);
+  process.SetMemoryBackend(backend);
+
+  BOOST_TEST(hadesmem::ReadString<char>(process, base + 0x100) ==
+             "Hello World!");
+  hadesmem::Write(process, base + 0x1ffc, 0x1337);
+  BOOST_TEST_EQ(hadesmem::Read<int>(process, base + 0x1ffc), 0x1337);
+  BOOST_TEST_EQ(*reinterpret_cast<int*>(&buf[0x1ffc]), 0x1337);
+  BOOST_TEST_THROWS(hadesmem::Read<int>(process, base + 0x1ffe),
+                    hadesmem::Error);
+  BOOST_TEST_THROWS(hadesmem::Read<int>(process, base - 4), hadesmem::Error);
+
+  // Protection is recorded but not enforced.
+  hadesmem::Protect(process, base, PAGE_READONLY);
+  BOOST_TEST(!hadesmem::CanWrite(process, base));
+  hadesmem::Write(process, base, 0x7331);
+  BOOST_TEST_EQ(hadesmem::Read<int>(process, base), 0x7331);
+  BOOST_TEST(!hadesmem::CanWrite(process, base));
+
+  hadesmem::RegionList const regions(process);
+  std::size_t num_regions = 0;
+  for (auto const& region : regions)
+  {
+    (void)region;
+    ++num_regions;
+  }
+  BOOST_TEST_EQ(num_regions, 2UL);
+
+  process.SetMemoryBackend(nullptr);
+  BOOST_TEST(process.GetMemoryBackend() == nullptr);
+}
+
+void TestBufferMemoryBackendPeFile()
+{
+  hadesmem::Process process(::GetCurrentProcessId());
+  hadesmem::PeFile const pe_file(
+    process, ::GetModuleHandleW(nullptr), hadesmem::PeFileType::Image, 0);
+  hadesmem::NtHeaders const nt_headers(process, pe_file);
+  DWORD const image_size = nt_headers.GetSizeOfImage();
+
+  auto const image = reinterpret_cast<std::uint8_t const*>(
+    ::GetModuleHandleW(nullptr));
+  std::vector<std::uint8_t> buf(image, image + image_size);
+  auto const base = reinterpret_cast<PVOID>(0x10000000);
+  process.SetMemoryBackend(
+    std::make_shared<hadesmem::BufferMemoryBackend>(base, std::move(buf)));
+
+  hadesmem::PeFile const pe_file_buf(
+    process, base, hadesmem::PeFileType::Image, image_size);
+  hadesmem::DosHeader const dos_header(process, pe_file_buf);
+  BOOST_TEST_EQ(dos_header.GetMagic(), IMAGE_DOS_SIGNATURE);
+  hadesmem::NtHeaders const nt_headers_buf(process, pe_file_buf);
+  BOOST_TEST_EQ(nt_headers_buf.GetSignature(),
+                static_cast<DWORD>(IMAGE_NT_SIGNATURE));
+  BOOST_TEST_EQ(nt_headers_buf.GetSizeOfImage(), image_size);
+}
+
+void TestLocalMemoryBackend()
+{
+  hadesmem::Process process(::GetCurrentProcessId());
+  BOOST_TEST(process.GetMemoryBackend() != nullptr);
+  BOOST_TEST(process.GetMemoryBackend()->IsDirect());
+  hadesmem::Process const process_copy(process);
+  BOOST_TEST_EQ(process_copy.GetMemoryBackend(), process.GetMemoryBackend());
+
+  int value = 0x1337;
+  BOOST_TEST_EQ(hadesmem::Read<int>(process, &value), 0x1337);
+  hadesmem::Write(process, &value, 0x7331);
+  BOOST_TEST_EQ(value, 0x7331);
+
+  PVOID const address =
+    VirtualAlloc(nullptr, 0x1000, MEM_RESERVE | MEM_COMMIT, PAGE_NOACCESS);
+  BOOST_TEST(address != 0);
+  std::uint32_t data = 0;
+  BOOST_TEST(!process.GetMemoryBackend()->Read(address, &data, sizeof(data)));
+  BOOST_TEST_EQ(::GetLastError(), static_cast<DWORD>(ERROR_NOACCESS));
+  hadesmem::Write(process, address, 0xDEADBEEFU);
+  BOOST_TEST_EQ(hadesmem::Read<std::uint32_t>(process, address), 0xDEADBEEFU);
+  BOOST_TEST(!hadesmem::CanRead(process, address));
+  BOOST_TEST(VirtualFree(address, 0, MEM_RELEASE) != 0);
+
+  // The guard is put back after a failed direct access, so guard pages are
+  // still rejected by the normal path.
+  PVOID const guard_page = VirtualAlloc(
+    nullptr, 0x1000, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE | PAGE_GUARD);
+  BOOST_TEST(guard_page != 0);
+  BOOST_TEST_THROWS(hadesmem::Read<int>(process, guard_page), hadesmem::Error);
+  BOOST_TEST(hadesmem::IsGuard(process, guard_page));
+  BOOST_TEST_THROWS(hadesmem::Write(process, guard_page, 0), hadesmem::Error);
+  BOOST_TEST(hadesmem::IsGuard(process, guard_page));
+  BOOST_TEST(VirtualFree(guard_page, 0, MEM_RELEASE) != 0);
+}
+
+int main()
+{
+  TestBufferMemoryBackend();
+  TestBufferMemoryBackendPeFile();
+  TestLocalMemoryBackend();
+  return boost::report_errors();
+}
@@ -0,0 +1,185 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#include <hadesmem/memory_watcher.hpp>
+#include <hadesmem/memory_watcher.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/snapshot_diff.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/read.hpp>
+#include <hadesmem/region.hpp>
+#include <hadesmem/remote_memory_cache.hpp>
+
+void TestDiffSnapshots()
+{
+  std::vector<std::uint8_t> old_data(100, 0);
+  std::vector<std::uint8_t> new_data(old_data);
+  new_data[3] = 1;
+  new_data[4] = 1;
+  new_data[7] = 1;
+  new_data[40] = 1;
+  new_data[99] = 1;
+
+  std::vector<std::pair<std::size_t, std::size_t>> runs;
+  auto const record = [&](std::size_t offset, std::size_t size)
+  {
+    runs.emplace_back(offset, size);
+  };
+  BOOST_TEST_EQ(hadesmem::detail::DiffSnapshots(
+                  old_data.data(), new_data.data(), 100, 0, record),
+                4UL);
+  BOOST_TEST(runs[0] == std::make_pair(std::size_t(3), std::size_t(2)));
+  BOOST_TEST(runs[1] == std::make_pair(std::size_t(7), std::size_t(1)));
+  BOOST_TEST(runs[2] == std::make_pair(std::size_t(40), std::size_t(1)));
+  BOOST_TEST(runs[3] == std::make_pair(std::size_t(99), std::size_t(1)));
+
+  // The gap between 4 and 7 is two bytes.
+  runs.clear();
+  BOOST_TEST_EQ(hadesmem::detail::DiffSnapshots(
+                  old_data.data(), new_data.data(), 100, 3, record),
+                3UL);
+  BOOST_TEST(runs[0] == std::make_pair(std::size_t(3), std::size_t(5)));
+
+  runs.clear();
+  BOOST_TEST_EQ(hadesmem::detail::DiffSnapshots(
+                  old_data.data(), old_data.data(), 100, 0, record),
+                0UL);
+  BOOST_TEST(runs.empty());
+}
+
+void TestMemoryWatcher()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+  hadesmem::MemoryWatcher watcher(process);
+
+  std::vector<std::uint32_t> data(0x100, 0);
+  watcher.AddRange(data.data(), data.size() * sizeof(std::uint32_t));
+  // Reserved but not committed, so it can't be read.
+  PVOID const reserved =
+    VirtualAlloc(nullptr, 0x1000, MEM_RESERVE, PAGE_NOACCESS);
+  BOOST_TEST(reserved != nullptr);
+  watcher.AddRange(reserved, 0x1000);
+  BOOST_TEST_EQ(watcher.GetNumRanges(), 2UL);
+
+  std::vector<hadesmem::MemoryChange> changes;
+  std::vector<std::uint8_t> old_bytes;
+  std::vector<std::uint8_t> new_bytes;
+  auto const record = [&](hadesmem::MemoryChange const& change)
+  {
+    changes.push_back(change);
+    old_bytes.insert(
+      old_bytes.end(), change.old_data, change.old_data + change.size);
+    new_bytes.insert(
+      new_bytes.end(), change.new_data, change.new_data + change.size);
+  };
+
+  data[1] = 0x1337;
+  BOOST_TEST_EQ(watcher.Poll(record), 0UL);
+  BOOST_TEST_EQ(watcher.Poll(record), 0UL);
+
+  data[0x10] = 0xFF;
+  BOOST_TEST_EQ(watcher.Poll(record), 1UL);
+  BOOST_TEST_EQ(changes.size(), 1UL);
+  BOOST_TEST(changes[0].address == &data[0x10]);
+  BOOST_TEST_EQ(changes[0].size, 1UL);
+  BOOST_TEST_EQ(old_bytes[0], 0);
+  BOOST_TEST_EQ(new_bytes[0], 0xFF);
+
+  BOOST_TEST_EQ(watcher.Poll(record), 0UL);
+
+  BOOST_TEST(VirtualFree(reserved, 0, MEM_RELEASE) != 0);
+}
+
+void TestMemoryWatcherRun()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+  hadesmem::MemoryWatcher watcher(process, std::chrono::milliseconds(1));
+
+  std::atomic<std::uint32_t> value(0);
+  watcher.AddRange(&value, sizeof(value));
+
+  std::atomic<bool> stop(false);
+  std::atomic<std::size_t> num_changes(0);
+  std::thread thread([&]()
+                     {
+    watcher.Run([&](hadesmem::MemoryChange const&)
+                {
+                  ++num_changes;
+                },
+                stop);
+  });
+
+  for (std::uint32_t i = 1; i < 10 && !num_changes; ++i)
+  {
+    value = i;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+
+  stop = true;
+  thread.join();
+  BOOST_TEST(num_changes != 0);
+}
+
+void TestMemoryWatcherAddRegions()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+  hadesmem::MemoryWatcher watcher(process);
+  std::size_t const num_added =
+    watcher.AddRegions([](hadesmem::Region const& region)
+                       {
+      return region.GetProtect() == PAGE_READWRITE &&
+             region.GetType() == MEM_PRIVATE;
+    });
+  BOOST_TEST(num_added != 0);
+  BOOST_TEST_EQ(watcher.GetNumRanges(), num_added);
+  watcher.Poll([](hadesmem::MemoryChange const&)
+               {
+  });
+}
+
+void TestMemoryWatcherCached()
+{
+  hadesmem::Process process(::GetCurrentProcessId());
+  process.SetMemoryCache(std::make_shared<hadesmem::RemoteMemoryCache>());
+  hadesmem::MemoryWatcher watcher(process);
+
+  std::uint32_t value = 0;
+  watcher.AddRange(&value, sizeof(value));
+  std::size_t num_changes = 0;
+  auto const record = [&](hadesmem::MemoryChange const&)
+  {
+    ++num_changes;
+  };
+  BOOST_TEST_EQ(hadesmem::Read<std::uint32_t>(process, &value), 0U);
+  BOOST_TEST_EQ(watcher.Poll(record), 0UL);
+
+  // Changes are seen even though the cached page is stale.
+  value = 0x1337;
+  BOOST_TEST_EQ(watcher.Poll(record), 1UL);
+  BOOST_TEST_EQ(num_changes, 1UL);
+  BOOST_TEST_EQ(hadesmem::Read<std::uint32_t>(process, &value), 0U);
+}
+
+int main()
+{
+  TestDiffSnapshots();
+  TestMemoryWatcher();
+  TestMemoryWatcherCached();
+  TestMemoryWatcherRun();
+  TestMemoryWatcherAddRegions();
+  return boost::report_errors();
+}
@@ -0,0 +1,123 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#include <hadesmem/pelib/export_index.hpp>
+#include <hadesmem/pelib/export_index.hpp>
+
+#include <string>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/alias_cast.hpp>
+#include <hadesmem/detail/find_procedure.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/pelib/export.hpp>
+#include <hadesmem/pelib/export_list.hpp>
+#include <hadesmem/pelib/pe_file.hpp>
+#include <hadesmem/procedure_resolver.hpp>
+#include <hadesmem/process.hpp>
+
+void TestExportIndexModule(hadesmem::Process const& process, HMODULE module)
+{
+  hadesmem::PeFile const pe_file(
+    process, module, hadesmem::PeFileType::Image, 0);
+  hadesmem::ExportList const exports(process, pe_file);
+  hadesmem::ExportIndex index(process, pe_file);
+
+  for (int i = 0; i < 2; ++i)
+  {
+    std::size_t num_named = 0;
+    for (auto const& e : exports)
+    {
+      BOOST_TEST(index.HasProcedure(e.GetProcedureNumber()) ||
+                 (!e.GetRva() && !e.IsForwarded()));
+      if (!e.ByName())
+      {
+        continue;
+      }
+
+      ++num_named;
+      WORD procedure_number = 0;
+      BOOST_TEST(index.FindProcedureNumber(e.GetName(), procedure_number));
+      BOOST_TEST_EQ(procedure_number, e.GetProcedureNumber());
+      hadesmem::Export const found = index.GetExport(procedure_number);
+      BOOST_TEST_EQ(found.GetName(), e.GetName());
+      BOOST_TEST_EQ(found.GetRva(), e.GetRva());
+    }
+
+    BOOST_TEST(num_named != 0);
+    WORD procedure_number = 0;
+    BOOST_TEST(
+      !index.FindProcedureNumber("non_existant_export", procedure_number));
+    BOOST_TEST(!index.FindProcedureNumber("", procedure_number));
+
+    index.BuildNameMap();
+    BOOST_TEST(index.HasNameMap());
+  }
+}
+
+void TestExportIndex()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+
+  TestExportIndexModule(process, ::GetModuleHandleW(L"ntdll.dll"));
+  TestExportIndexModule(process, ::GetModuleHandleW(L"kernel32.dll"));
+}
+
+void TestProcedureResolver()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+
+  HMODULE const kernel32 = ::GetModuleHandleW(L"kernel32.dll");
+  HMODULE const ntdll = ::GetModuleHandleW(L"ntdll.dll");
+  hadesmem::ProcedureResolver resolver(process);
+
+  // Enough lookups to switch kernel32 over to the name map, including
+  // forwarded exports (HeapAlloc is forwarded to ntdll).
+  char const* const names[] = {"HeapAlloc",
+                               "HeapFree",
+                               "GetLastError",
+                               "SetLastError",
+                               "LoadLibraryExW",
+                               "FreeLibrary",
+                               "GetProcAddress",
+                               "GetModuleHandleW"};
+  for (int i = 0; i < 3; ++i)
+  {
+    for (auto const name : names)
+    {
+      BOOST_TEST_EQ(resolver.Find(kernel32, name),
+                    ::GetProcAddress(kernel32, name));
+    }
+  }
+
+  BOOST_TEST_EQ(resolver.Find(ntdll, "RtlRandom"),
+                ::GetProcAddress(ntdll, "RtlRandom"));
+  BOOST_TEST_EQ(resolver.Find(ntdll, "non_existant_export"),
+                static_cast<FARPROC>(nullptr));
+
+  hadesmem::PeFile const pe_file(
+    process, ntdll, hadesmem::PeFileType::Image, 0);
+  hadesmem::ExportIndex const index(process, pe_file);
+  WORD procedure_number = 0;
+  BOOST_TEST(index.FindProcedureNumber("RtlRandom", procedure_number));
+  BOOST_TEST_EQ(resolver.Find(ntdll, procedure_number),
+                ::GetProcAddress(ntdll, "RtlRandom"));
+  BOOST_TEST_EQ(
+    hadesmem::detail::GetProcAddressInternal(process, ntdll, procedure_number),
+    ::GetProcAddress(ntdll, "RtlRandom"));
+
+  resolver.Clear();
+  BOOST_TEST_EQ(resolver.Find(kernel32, "HeapAlloc"),
+                ::GetProcAddress(kernel32, "HeapAlloc"));
+}
+
+int main()
+{
+  TestExportIndex();
+  TestProcedureResolver();
+  return boost::report_errors();
+}
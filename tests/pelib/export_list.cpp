@@ -4,8 +4,11 @@
 #include <hadesmem/pelib/export_list.hpp>
 #include <hadesmem/pelib/export_list.hpp>
 
+#include <cstdint>
+#include <cstring>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 #include <hadesmem/detail/warning_disable_prefix.hpp>
 #include <boost/detail/lightweight_test.hpp>
@@ -17,6 +20,7 @@
 #include <hadesmem/module_list.hpp>
 #include <hadesmem/pelib/export.hpp>
 #include <hadesmem/pelib/export_dir.hpp>
+#include <hadesmem/pelib/nt_headers.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
 #include <hadesmem/read.hpp>
@@ -56,6 +60,11 @@ void TestExportList()
     {
       hadesmem::Export const test_export(
         process, cur_pe_file, e.GetProcedureNumber());
+      BOOST_TEST_EQ(test_export.ByName(), e.ByName());
+      BOOST_TEST_EQ(test_export.GetName(), e.GetName());
+      BOOST_TEST_EQ(test_export.IsForwarded(), e.IsForwarded());
+      BOOST_TEST_EQ(test_export.GetForwarder(), e.GetForwarder());
+      BOOST_TEST_EQ(test_export.GetRva(), e.GetRva());
 
       if (test_export.ByName())
       {
@@ -93,8 +102,93 @@ void TestExportList()
   BOOST_TEST(processed_one_export_list);
 }
 
+void TestExportListData()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+
+  // Headers with no sections, so RVAs are file offsets.
+  std::vector<std::uint8_t> buf(0x400);
+  auto const dos_header = reinterpret_cast<IMAGE_DOS_HEADER*>(buf.data());
+  dos_header->e_magic = IMAGE_DOS_SIGNATURE;
+  dos_header->e_lfanew = 0x40;
+  auto const nt_headers =
+    reinterpret_cast<IMAGE_NT_HEADERS*>(buf.data() + dos_header->e_lfanew);
+  hadesmem::PeFile const pe_file_this(
+    process, ::GetModuleHandleW(nullptr), hadesmem::PeFileType::Image, 0);
+  hadesmem::NtHeaders const nt_headers_this(process, pe_file_this);
+  std::memcpy(
+    nt_headers, nt_headers_this.GetBase(), sizeof(IMAGE_NT_HEADERS));
+  nt_headers->FileHeader.NumberOfSections = 0;
+  nt_headers->FileHeader.SizeOfOptionalHeader =
+    sizeof(IMAGE_OPTIONAL_HEADER);
+  nt_headers->OptionalHeader.SizeOfHeaders = 0x200;
+  nt_headers->OptionalHeader.SizeOfImage = 0x400;
+  nt_headers->OptionalHeader.NumberOfRvaAndSizes =
+    IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+  nt_headers->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT] = {
+    0x200, 0x100};
+
+  auto const export_dir =
+    reinterpret_cast<IMAGE_EXPORT_DIRECTORY*>(buf.data() + 0x200);
+  export_dir->Base = 5;
+  export_dir->NumberOfFunctions = 4;
+  export_dir->NumberOfNames = 4;
+  export_dir->AddressOfFunctions = 0x240;
+  export_dir->AddressOfNames = 0x260;
+  export_dir->AddressOfNameOrdinals = 0x280;
+
+  // Ordinal 1 is unused and skipped, ordinal 2 is forwarded. Ordinal 0 has
+  // two names (the first wins), and the last name has an invalid ordinal.
+  DWORD const functions[] = {0x310, 0, 0x2C0, 0x320};
+  DWORD const names[] = {0x2A0, 0x2A8, 0x2B0, 0x2B8};
+  WORD const name_ordinals[] = {3, 0, 0, 9};
+  std::memcpy(&buf[0x240], functions, sizeof(functions));
+  std::memcpy(&buf[0x260], names, sizeof(names));
+  std::memcpy(&buf[0x280], name_ordinals, sizeof(name_ordinals));
+  std::memcpy(&buf[0x2A0], "Alpha", 6);
+  std::memcpy(&buf[0x2A8], "Beta", 5);
+  std::memcpy(&buf[0x2B0], "Gamma", 6);
+  std::memcpy(&buf[0x2B8], "Delta", 6);
+  std::memcpy(&buf[0x2C0], "Other.Func", 11);
+
+  hadesmem::PeFile const pe_file(process,
+                                 buf.data(),
+                                 hadesmem::PeFileType::Data,
+                                 static_cast<DWORD>(buf.size()));
+  hadesmem::ExportList const exports(process, pe_file);
+  std::vector<hadesmem::Export> const export_vec(std::begin(exports),
+                                                 std::end(exports));
+  BOOST_TEST_EQ(export_vec.size(), 3UL);
+  if (export_vec.size() != 3)
+  {
+    return;
+  }
+
+  BOOST_TEST_EQ(export_vec[0].GetProcedureNumber(), 5);
+  BOOST_TEST(export_vec[0].ByName());
+  BOOST_TEST_EQ(export_vec[0].GetName(), "Beta");
+  BOOST_TEST_EQ(export_vec[0].GetRva(), 0x310UL);
+
+  BOOST_TEST_EQ(export_vec[1].GetProcedureNumber(), 7);
+  BOOST_TEST(export_vec[1].ByOrdinal());
+  BOOST_TEST(export_vec[1].IsForwarded());
+  BOOST_TEST_EQ(export_vec[1].GetForwarderModule(), "Other");
+  BOOST_TEST_EQ(export_vec[1].GetForwarderFunction(), "Func");
+
+  BOOST_TEST_EQ(export_vec[2].GetProcedureNumber(), 8);
+  BOOST_TEST_EQ(export_vec[2].GetName(), "Alpha");
+  BOOST_TEST_EQ(export_vec[2].GetRva(), 0x320UL);
+
+  hadesmem::Export const unused(process, pe_file, 6);
+  BOOST_TEST(unused.ByOrdinal());
+  BOOST_TEST_EQ(unused.GetRva(), 0UL);
+
+  BOOST_TEST_THROWS(hadesmem::Export(process, pe_file, 9), hadesmem::Error);
+}
+
 int main()
 {
   TestExportList();
+  TestExportListData();
   return boost::report_errors();
 }
@@ -0,0 +1,201 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#include <hadesmem/pelib/import_table.hpp>
+#include <hadesmem/pelib/import_table.hpp>
+
+#include <algorithm>
+#include <ios>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/filesystem.hpp>
+#include <hadesmem/detail/self_path.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/module.hpp>
+#include <hadesmem/module_list.hpp>
+#include <hadesmem/pelib/import_dir.hpp>
+#include <hadesmem/pelib/import_dir_list.hpp>
+#include <hadesmem/pelib/import_thunk.hpp>
+#include <hadesmem/pelib/import_thunk_list.hpp>
+#include <hadesmem/pelib/pe_file.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/read.hpp>
+
+void TestImportTable()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+
+  bool processed_one_import_table = false;
+
+  hadesmem::ModuleList modules(process);
+  for (auto const& mod : modules)
+  {
+    hadesmem::PeFile const cur_pe_file(
+      process, mod.GetHandle(), hadesmem::PeFileType::Image, 0);
+
+    hadesmem::ImportDirList const import_dirs(process, cur_pe_file);
+    hadesmem::ImportTable const import_table(process, cur_pe_file);
+
+    auto table_iter = std::begin(import_table);
+    for (auto const& d : import_dirs)
+    {
+      BOOST_TEST(table_iter != std::end(import_table));
+      if (table_iter == std::end(import_table))
+      {
+        break;
+      }
+
+      hadesmem::ImportTableDir const& table_dir = *table_iter++;
+      BOOST_TEST_EQ(table_dir.GetBase(), d.GetBase());
+      BOOST_TEST_EQ(table_dir.GetOriginalFirstThunk(),
+                    d.GetOriginalFirstThunk());
+      BOOST_TEST_EQ(table_dir.GetFirstThunk(), d.GetFirstThunk());
+      BOOST_TEST_EQ(table_dir.GetName(), d.GetName());
+
+      DWORD const names_rva = d.GetOriginalFirstThunk()
+                                ? d.GetOriginalFirstThunk()
+                                : d.GetFirstThunk();
+      hadesmem::ImportThunkList const import_thunks(
+        process, cur_pe_file, names_rva);
+      auto const table_thunks = import_table.GetThunks(table_dir);
+      BOOST_TEST_EQ(
+        static_cast<std::size_t>(
+          std::distance(std::begin(import_thunks), std::end(import_thunks))),
+        table_thunks.size());
+      BOOST_TEST_EQ(table_thunks.size(), table_dir.GetNumThunks());
+
+      auto table_thunk = std::begin(table_thunks);
+      for (auto const& t : import_thunks)
+      {
+        if (table_thunk == std::end(table_thunks))
+        {
+          break;
+        }
+
+        BOOST_TEST_EQ(table_thunk->GetBase(), t.GetBase());
+        BOOST_TEST_EQ(table_thunk->GetAddressOfData(), t.GetAddressOfData());
+        BOOST_TEST_EQ(table_thunk->ByOrdinal(), t.ByOrdinal());
+        if (t.ByOrdinal())
+        {
+          BOOST_TEST_EQ(table_thunk->GetOrdinal(), t.GetOrdinal());
+        }
+        else
+        {
+          BOOST_TEST_EQ(table_thunk->GetHint(), t.GetHint());
+          BOOST_TEST_EQ(table_thunk->GetName(), t.GetName());
+        }
+
+        BOOST_TEST(table_thunk->GetIatBase() != nullptr);
+        BOOST_TEST_EQ(table_thunk->GetFunction(),
+                      hadesmem::Read<DWORD_PTR>(process,
+                                                table_thunk->GetIatBase()));
+
+        ++table_thunk;
+        processed_one_import_table = true;
+      }
+    }
+
+    BOOST_TEST(table_iter == std::end(import_table));
+  }
+
+  BOOST_TEST(processed_one_import_table);
+}
+
+bool IsKernel32(hadesmem::ImportTableDir const& d)
+{
+  std::string const name = d.GetName();
+  return name == "kernel32" || name == "kernel32.dll" ||
+         name == "KERNEL32.dll" || name == "KERNEL32.DLL";
+}
+
+void TestImportTablePatch()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+
+  hadesmem::PeFile const pe_file_this(
+    process, ::GetModuleHandleW(nullptr), hadesmem::PeFileType::Image, 0);
+  hadesmem::ImportTable const import_table_this(process, pe_file_this);
+  auto const dir_this = std::find_if(
+    std::begin(import_table_this), std::end(import_table_this), &IsKernel32);
+  BOOST_TEST(dir_this != std::end(import_table_this));
+  if (dir_this != std::end(import_table_this))
+  {
+    auto const thunks = import_table_this.GetThunks(*dir_this);
+    auto const get_current_process_id =
+      std::find_if(std::begin(thunks),
+                   std::end(thunks),
+                   [](hadesmem::ImportTableThunk const& t)
+                   {
+      return !t.ByOrdinal() && t.GetName() == "GetCurrentProcessId";
+    });
+    BOOST_TEST(get_current_process_id != std::end(thunks));
+    if (get_current_process_id != std::end(thunks))
+    {
+      BOOST_TEST_EQ(get_current_process_id->GetFunction(),
+                    reinterpret_cast<DWORD_PTR>(&::GetCurrentProcessId));
+    }
+  }
+
+  // Patch a copy of our own file rather than the live IAT, which is in use.
+  auto const file = hadesmem::detail::OpenFile<char>(
+    hadesmem::detail::GetSelfPath(), std::ios::in | std::ios::binary);
+  BOOST_TEST(!!*file);
+  std::vector<char> buf((std::istreambuf_iterator<char>(*file)),
+                        std::istreambuf_iterator<char>());
+  hadesmem::PeFile const pe_file(process,
+                                 buf.data(),
+                                 hadesmem::PeFileType::Data,
+                                 static_cast<DWORD>(buf.size()));
+  hadesmem::ImportTable import_table(process, pe_file);
+  auto const dir =
+    std::find_if(std::begin(import_table), std::end(import_table), &IsKernel32);
+  BOOST_TEST(dir != std::end(import_table));
+  if (dir == std::end(import_table))
+  {
+    return;
+  }
+
+  // Patch every entry of the IAT at once.
+  auto const thunks = import_table.GetThunks(*dir);
+  BOOST_TEST(thunks.size() != 0);
+  for (auto& thunk : thunks)
+  {
+    thunk.SetFunction(~thunk.GetFunction());
+  }
+  BOOST_TEST_EQ(import_table.UpdateWrite(), thunks.size());
+  BOOST_TEST_EQ(import_table.UpdateWrite(), 0U);
+
+  hadesmem::ImportTable const import_table_new(process, pe_file);
+  auto const dir_new = std::find_if(
+    std::begin(import_table_new), std::end(import_table_new), &IsKernel32);
+  BOOST_TEST(dir_new != std::end(import_table_new));
+  if (dir_new == std::end(import_table_new))
+  {
+    return;
+  }
+
+  auto const thunks_new = import_table_new.GetThunks(*dir_new);
+  BOOST_TEST_EQ(thunks_new.size(), thunks.size());
+  for (std::size_t i = 0; i < thunks.size() && i < thunks_new.size(); ++i)
+  {
+    BOOST_TEST_EQ(thunks_new.begin()[i].GetFunction(),
+                  thunks.begin()[i].GetFunction());
+    BOOST_TEST_EQ(hadesmem::Read<DWORD_PTR>(
+                    process, thunks_new.begin()[i].GetIatBase()),
+                  thunks.begin()[i].GetFunction());
+  }
+}
+
+int main()
+{
+  TestImportTable();
+  TestImportTablePatch();
+  return boost::report_errors();
+}
@@ -4,16 +4,25 @@
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 
+#include <cstdint>
+#include <iterator>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 #include <hadesmem/detail/warning_disable_prefix.hpp>
 #include <boost/detail/lightweight_test.hpp>
 #include <hadesmem/detail/warning_disable_suffix.hpp>
 
 #include <hadesmem/config.hpp>
+#include <hadesmem/detail/filesystem.hpp>
+#include <hadesmem/detail/self_path.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/module.hpp>
+#include <hadesmem/pelib/dos_header.hpp>
+#include <hadesmem/pelib/nt_headers.hpp>
+#include <hadesmem/pelib/section.hpp>
+#include <hadesmem/pelib/section_list.hpp>
 #include <hadesmem/process.hpp>
 
 void TestPeFile()
@@ -77,8 +86,70 @@ void TestPeFile()
   BOOST_TEST_NE(test_str_1.str(), test_str_3.str());
 }
 
+void TestPeFileDataRvaToVa()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+
+  auto const file = hadesmem::detail::OpenFile<char>(
+    hadesmem::detail::GetSelfPath(), std::ios::in | std::ios::binary);
+  BOOST_TEST(!!*file);
+  std::vector<char> buf((std::istreambuf_iterator<char>(*file)),
+                        std::istreambuf_iterator<char>());
+  BOOST_TEST(!buf.empty());
+
+  hadesmem::PeFile const pe_file(process,
+                                 buf.data(),
+                                 hadesmem::PeFileType::Data,
+                                 static_cast<DWORD>(buf.size()));
+  BOOST_TEST_EQ(hadesmem::RvaToVa(process, pe_file, 0),
+                static_cast<void*>(nullptr));
+  BOOST_TEST_EQ(hadesmem::RvaToVa(process, pe_file, 1),
+                static_cast<void*>(buf.data() + 1));
+
+  auto const headers = pe_file.GetHeaders();
+  hadesmem::NtHeaders const nt_headers(process, pe_file);
+  BOOST_TEST_EQ(headers->num_sections, nt_headers.GetNumberOfSections());
+  BOOST_TEST_EQ(headers->sections.size(),
+                static_cast<std::size_t>(nt_headers.GetNumberOfSections()));
+
+  hadesmem::SectionList const sections(process, pe_file);
+  for (auto const& section : sections)
+  {
+    if (!section.GetSizeOfRawData())
+    {
+      continue;
+    }
+
+    void* const expected =
+      buf.data() + (section.GetPointerToRawData() & ~(0x1FFUL));
+    BOOST_TEST_EQ(
+      hadesmem::RvaToVa(process, pe_file, section.GetVirtualAddress()),
+      expected);
+    BOOST_TEST_EQ(
+      hadesmem::RvaToVa(process, pe_file, section.GetVirtualAddress() + 1),
+      static_cast<void*>(static_cast<char*>(expected) + 1));
+  }
+
+  // The parsed headers are kept (and shared with copies) until invalidated.
+  hadesmem::PeFile const pe_file_copy(pe_file);
+  BOOST_TEST(pe_file_copy.GetHeaders() == headers);
+  BOOST_TEST(pe_file.GetHeaders() == headers);
+  pe_file.InvalidateHeaders();
+  BOOST_TEST(pe_file_copy.GetHeaders() != headers);
+
+  // As are writes through the header classes.
+  auto const headers_new = pe_file.GetHeaders();
+  hadesmem::DosHeader dos_header(process, pe_file);
+  dos_header.UpdateWrite();
+  BOOST_TEST(pe_file.GetHeaders() != headers_new);
+
+  BOOST_TEST_EQ(hadesmem::RvaToVa(process, pe_file, 0xFFFFFFFF),
+                static_cast<void*>(nullptr));
+}
+
 int main()
 {
   TestPeFile();
+  TestPeFileDataRvaToVa();
   return boost::report_errors();
 }
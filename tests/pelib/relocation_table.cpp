@@ -0,0 +1,216 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#include <hadesmem/pelib/relocation_table.hpp>
+#include <hadesmem/pelib/relocation_table.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/module.hpp>
+#include <hadesmem/module_list.hpp>
+#include <hadesmem/pelib/nt_headers.hpp>
+#include <hadesmem/pelib/pe_file.hpp>
+#include <hadesmem/pelib/relocation.hpp>
+#include <hadesmem/pelib/relocation_block.hpp>
+#include <hadesmem/pelib/relocation_block_list.hpp>
+#include <hadesmem/pelib/relocation_list.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/read.hpp>
+
+void TestRelocationTable()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+
+  bool processed_one_relocation = false;
+
+  hadesmem::ModuleList modules(process);
+  for (auto const& mod : modules)
+  {
+    hadesmem::PeFile const cur_pe_file(
+      process, mod.GetHandle(), hadesmem::PeFileType::Image, 0);
+
+    hadesmem::RelocationBlockList const blocks(process, cur_pe_file);
+    hadesmem::RelocationTable const table(process, cur_pe_file);
+
+    auto table_iter = std::begin(table);
+    std::size_t num_relocs = 0;
+    for (auto const& block : blocks)
+    {
+      BOOST_TEST(table_iter != std::end(table));
+      if (table_iter == std::end(table))
+      {
+        break;
+      }
+
+      hadesmem::RelocationTableBlock const& table_block = *table_iter++;
+      BOOST_TEST_EQ(table_block.GetBase(), block.GetBase());
+      BOOST_TEST_EQ(table_block.GetVirtualAddress(), block.GetVirtualAddress());
+      BOOST_TEST_EQ(table_block.GetSizeOfBlock(), block.GetSizeOfBlock());
+      BOOST_TEST_EQ(table_block.GetNumberOfRelocations(),
+                    block.GetNumberOfRelocations());
+
+      hadesmem::RelocationList const relocs(process,
+                                            cur_pe_file,
+                                            block.GetRelocationDataStart(),
+                                            block.GetNumberOfRelocations());
+      DWORD i = 0;
+      for (auto const& reloc : relocs)
+      {
+        if (i >= table_block.GetNumberOfRelocations())
+        {
+          break;
+        }
+
+        BOOST_TEST_EQ(table_block.GetType(i), reloc.GetType());
+        BOOST_TEST_EQ(table_block.GetOffset(i), reloc.GetOffset());
+        ++i;
+        processed_one_relocation = true;
+      }
+
+      BOOST_TEST_EQ(i, table_block.GetNumberOfRelocations());
+      num_relocs += i;
+    }
+
+    BOOST_TEST(table_iter == std::end(table));
+    BOOST_TEST_EQ(table.GetNumberOfRelocations(), num_relocs);
+  }
+
+  BOOST_TEST(processed_one_relocation);
+}
+
+template <typename T> T ReadTarget(std::vector<std::uint8_t> const& buf,
+                                   std::size_t offset)
+{
+  T value;
+  std::memcpy(&value, &buf[offset], sizeof(value));
+  return value;
+}
+
+void TestRelocationTableApply()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+
+  // Headers with no sections, laid out as an image.
+  std::vector<std::uint8_t> buf(0x400);
+  auto const dos_header = reinterpret_cast<IMAGE_DOS_HEADER*>(buf.data());
+  dos_header->e_magic = IMAGE_DOS_SIGNATURE;
+  dos_header->e_lfanew = 0x40;
+  auto const nt_headers =
+    reinterpret_cast<IMAGE_NT_HEADERS*>(buf.data() + dos_header->e_lfanew);
+  hadesmem::PeFile const pe_file_this(
+    process, ::GetModuleHandleW(nullptr), hadesmem::PeFileType::Image, 0);
+  hadesmem::NtHeaders const nt_headers_this(process, pe_file_this);
+  std::memcpy(
+    nt_headers, nt_headers_this.GetBase(), sizeof(IMAGE_NT_HEADERS));
+  nt_headers->FileHeader.NumberOfSections = 0;
+  nt_headers->FileHeader.SizeOfOptionalHeader =
+    sizeof(IMAGE_OPTIONAL_HEADER);
+  nt_headers->OptionalHeader.SizeOfHeaders = 0x200;
+  nt_headers->OptionalHeader.SizeOfImage = 0x400;
+  nt_headers->OptionalHeader.NumberOfRvaAndSizes =
+    IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+  nt_headers->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC] =
+    {0x200, 0x24};
+
+  // The second HIGHADJ entry holds the low half of the target.
+  IMAGE_BASE_RELOCATION const block_1 = {0x300, 0x18};
+  WORD const relocs_1[] = {0x3000, 0xA008, 0x1010, 0x2014,
+                           0x4018, 0x9000, 0x0000, 0x0000};
+  IMAGE_BASE_RELOCATION const block_2 = {0x380, 0x0C};
+  WORD const relocs_2[] = {0x3000, 0x0000};
+  std::memcpy(&buf[0x200], &block_1, sizeof(block_1));
+  std::memcpy(&buf[0x208], relocs_1, sizeof(relocs_1));
+  std::memcpy(&buf[0x218], &block_2, sizeof(block_2));
+  std::memcpy(&buf[0x220], relocs_2, sizeof(relocs_2));
+
+  DWORD const highlow = 0x10001000;
+  ULONGLONG const dir64 = 0x0000000180001000ULL;
+  WORD const high = 0x1000;
+  WORD const low = 0x1000;
+  WORD const high_adj = 0x1000;
+  std::memcpy(&buf[0x300], &highlow, sizeof(highlow));
+  std::memcpy(&buf[0x308], &dir64, sizeof(dir64));
+  std::memcpy(&buf[0x310], &high, sizeof(high));
+  std::memcpy(&buf[0x314], &low, sizeof(low));
+  std::memcpy(&buf[0x318], &high_adj, sizeof(high_adj));
+  std::memcpy(&buf[0x380], &highlow, sizeof(highlow));
+
+  hadesmem::PeFile const pe_file(
+    process, buf.data(), hadesmem::PeFileType::Image, 0);
+  hadesmem::RelocationTable const table(process, pe_file);
+  BOOST_TEST_EQ(table.size(), 2UL);
+  BOOST_TEST_EQ(table.GetNumberOfRelocations(), 10UL);
+  if (table.size() != 2)
+  {
+    return;
+  }
+
+  BOOST_TEST_EQ(std::begin(table)[0].GetVirtualAddress(), 0x300UL);
+  BOOST_TEST_EQ(std::begin(table)[0].GetType(1), IMAGE_REL_BASED_DIR64);
+  BOOST_TEST_EQ(std::begin(table)[0].GetOffset(1), 0x008);
+  BOOST_TEST_EQ(std::begin(table)[1].GetVirtualAddress(), 0x380UL);
+  BOOST_TEST_EQ(std::begin(table)[1].GetNumberOfRelocations(), 2UL);
+
+  std::vector<std::uint8_t> const buf_orig(buf);
+  ULONGLONG const delta = 0x12345678;
+  std::vector<std::uint8_t> buf_copy(buf);
+  BOOST_TEST_EQ(table.Apply(buf_copy.data(), buf_copy.size(), delta), 6UL);
+  BOOST_TEST_EQ(ReadTarget<DWORD>(buf_copy, 0x300), 0x22346678UL);
+  BOOST_TEST_EQ(ReadTarget<ULONGLONG>(buf_copy, 0x308),
+                0x0000000192346678ULL);
+  BOOST_TEST_EQ(ReadTarget<WORD>(buf_copy, 0x310), 0x2234);
+  BOOST_TEST_EQ(ReadTarget<WORD>(buf_copy, 0x314), 0x6678);
+  // 0x0FFF9000 + delta is 0x2232E678, which rounds up to 0x2233.
+  BOOST_TEST_EQ(ReadTarget<WORD>(buf_copy, 0x318), 0x2233);
+  BOOST_TEST_EQ(ReadTarget<DWORD>(buf_copy, 0x380), 0x22346678UL);
+
+  BOOST_TEST_THROWS(table.Apply(buf_copy.data(), 0x382, delta),
+                    hadesmem::Error);
+
+  // Rebase the image in place and back again.
+  ULONG_PTR const image_base = nt_headers->OptionalHeader.ImageBase;
+  BOOST_TEST_EQ(hadesmem::ApplyRelocations(process, pe_file, delta), 6UL);
+  BOOST_TEST_EQ(ReadTarget<DWORD>(buf, 0x380), 0x22346678UL);
+  BOOST_TEST_EQ(nt_headers->OptionalHeader.ImageBase,
+                static_cast<ULONG_PTR>(image_base + delta));
+  BOOST_TEST_EQ(hadesmem::ApplyRelocations(process, pe_file, 0 - delta), 6UL);
+  // HIGHADJ can't be reversed, as the low half stored with it isn't updated.
+  BOOST_TEST_EQ(ReadTarget<WORD>(buf, 0x318), 0x0FFE);
+  std::memcpy(&buf[0x318], &high_adj, sizeof(high_adj));
+  BOOST_TEST(buf == buf_orig);
+
+  // Read-only images are handled, and their protection is left as it was.
+  auto const image = static_cast<std::uint8_t*>(VirtualAlloc(
+    nullptr, buf.size(), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  BOOST_TEST(image != 0);
+  std::memcpy(image, buf.data(), buf.size());
+  DWORD old_protect = 0;
+  BOOST_TEST(
+    VirtualProtect(image, buf.size(), PAGE_READONLY, &old_protect) != 0);
+  hadesmem::PeFile const pe_file_ro(
+    process, image, hadesmem::PeFileType::Image, 0);
+  BOOST_TEST_EQ(hadesmem::ApplyRelocations(process, pe_file_ro, delta), 6UL);
+  DWORD highlow_new = 0;
+  std::memcpy(&highlow_new, image + 0x380, sizeof(highlow_new));
+  BOOST_TEST_EQ(highlow_new, 0x22346678UL);
+  MEMORY_BASIC_INFORMATION mbi = {};
+  BOOST_TEST(VirtualQuery(image, &mbi, sizeof(mbi)) != 0);
+  BOOST_TEST_EQ(mbi.Protect, static_cast<DWORD>(PAGE_READONLY));
+  BOOST_TEST(VirtualFree(image, 0, MEM_RELEASE) != 0);
+}
+
+int main()
+{
+  TestRelocationTable();
+  TestRelocationTableApply();
+  return boost::report_errors();
+}
@@ -0,0 +1,119 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#include <hadesmem/pointer_chain.hpp>
+#include <hadesmem/pointer_chain.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/process.hpp>
+
+namespace
+{
+struct Constraints
+{
+  int unknown[4];
+  float distance;
+};
+
+struct Manager
+{
+  void* unknown[3];
+  Constraints* constraints;
+};
+}
+
+void TestPointerChain()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+
+  Constraints constraints_1 = {{1, 2, 3, 4}, 1.0f};
+  Constraints constraints_2 = {{5, 6, 7, 8}, 2.0f};
+  Manager manager_1 = {{}, &constraints_1};
+  Manager manager_2 = {{}, &constraints_2};
+  Manager* global_manager = &manager_1;
+
+  std::vector<std::ptrdiff_t> const offsets = {
+    0,
+    offsetof(Manager, constraints),
+    offsetof(Constraints, distance)};
+  hadesmem::PointerChain chain(process, &global_manager, offsets);
+  BOOST_TEST_EQ(chain.GetNumLevels(), 3UL);
+
+  BOOST_TEST_EQ(chain.Resolve(), static_cast<PVOID>(&constraints_1.distance));
+  BOOST_TEST_EQ(chain.GetLevelBase(1), static_cast<PVOID>(&manager_1));
+  BOOST_TEST_EQ(chain.GetNumReads(), 2ULL);
+
+  // Nothing moved, so only the root pointer is read.
+  BOOST_TEST_EQ(chain.Resolve(), static_cast<PVOID>(&constraints_1.distance));
+  BOOST_TEST_EQ(chain.GetNumReads(), 3ULL);
+
+  // The root moved, so everything below it is read again.
+  global_manager = &manager_2;
+  BOOST_TEST_EQ(chain.Resolve(), static_cast<PVOID>(&constraints_2.distance));
+  BOOST_TEST_EQ(chain.GetNumReads(), 5ULL);
+
+  // A change further down is only picked up after invalidation.
+  manager_2.constraints = &constraints_1;
+  BOOST_TEST_EQ(chain.Resolve(), static_cast<PVOID>(&constraints_2.distance));
+  std::uint32_t const generation = chain.GetGeneration();
+  chain.Invalidate();
+  BOOST_TEST_NE(chain.GetGeneration(), generation);
+  BOOST_TEST_EQ(chain.Resolve(), static_cast<PVOID>(&constraints_1.distance));
+  BOOST_TEST_EQ(chain.ResolveUncached(),
+                static_cast<PVOID>(&constraints_1.distance));
+
+  manager_2.constraints = nullptr;
+  BOOST_TEST_THROWS(chain.ResolveUncached(), hadesmem::Error);
+}
+
+void TestPointerChainWindow()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+
+  Constraints constraints = {{1, 2, 3, 4}, 1.0f};
+  Manager manager = {{}, &constraints};
+  Manager* global_manager = &manager;
+
+  std::vector<std::ptrdiff_t> const offsets = {
+    0,
+    offsetof(Manager, constraints),
+    offsetof(Constraints, distance)};
+  hadesmem::PointerChain chain(process, &global_manager, offsets);
+  chain.SetWindow(1, 0, sizeof(Manager));
+  chain.SetWindow(2, 0, sizeof(Constraints));
+  BOOST_TEST_THROWS(chain.SetWindow(1, 0, sizeof(void*)), hadesmem::Error);
+  BOOST_TEST_THROWS(chain.GetField<float>(2, 0), hadesmem::Error);
+
+  BOOST_TEST_EQ(chain.Resolve(), static_cast<PVOID>(&constraints.distance));
+  BOOST_TEST_EQ(chain.GetNumReads(), 3ULL);
+  BOOST_TEST_EQ(
+    chain.GetField<float>(2, offsetof(Constraints, distance)), 1.0f);
+  BOOST_TEST_EQ(chain.GetField<int>(2, offsetof(Constraints, unknown) + 8), 3);
+  BOOST_TEST_EQ(chain.GetField<Constraints*>(1, offsetof(Manager, constraints)),
+                &constraints);
+  BOOST_TEST_THROWS(chain.GetField<float>(2, sizeof(Constraints)),
+                    hadesmem::Error);
+
+  // Windows are refreshed on every resolution.
+  constraints.distance = 2.0f;
+  chain.Resolve();
+  BOOST_TEST_EQ(
+    chain.GetField<float>(2, offsetof(Constraints, distance)), 2.0f);
+  BOOST_TEST_EQ(chain.GetNumReads(), 6ULL);
+}
+
+int main()
+{
+  TestPointerChain();
+  TestPointerChainWindow();
+  return boost::report_errors();
+}
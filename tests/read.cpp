@@ -18,6 +18,7 @@
 #include <hadesmem/detail/winapi.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/process.hpp>
+#include <hadesmem/protect.hpp>
 
 void TestReadPod()
 {
@@ -106,6 +107,15 @@ void TestReadString()
   auto const wide_new_test_string_2 =
     hadesmem::ReadStringEx<wchar_t>(process, str_mem_wide, 1);
   BOOST_TEST(wide_new_test_string_2 == wide_test_string_2);
+
+  // Strings on guard pages are rejected without tripping the guard.
+  PVOID const guard_page = VirtualAlloc(
+    nullptr, 0x1000, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE | PAGE_GUARD);
+  BOOST_TEST(guard_page != nullptr);
+  BOOST_TEST_THROWS(hadesmem::ReadString<char>(process, guard_page),
+                    hadesmem::Error);
+  BOOST_TEST(hadesmem::IsGuard(process, guard_page));
+  BOOST_TEST(VirtualFree(guard_page, 0, MEM_RELEASE) != 0);
 }
 
 void TestReadVector()
@@ -142,11 +152,79 @@ void TestReadCrossRegion()
   BOOST_TEST(buf == zero_buf);
 }
 
+void TestReadRegionCache()
+{
+  hadesmem::Process process(::GetCurrentProcessId());
+  // Direct access doesn't query regions at all unless an access fails.
+  process.SetMemoryBackend(nullptr);
+  BOOST_TEST(!process.IsRegionCacheEnabled());
+  process.EnableRegionCache();
+  BOOST_TEST(process.IsRegionCacheEnabled());
+  hadesmem::detail::RegionCache& cache = *process.GetRegionCache();
+
+  hadesmem::Process const process_copy(process);
+  BOOST_TEST_EQ(process_copy.GetRegionCache(), &cache);
+
+  SYSTEM_INFO const sys_info = hadesmem::detail::GetSystemInfo();
+  DWORD const page_size = sys_info.dwPageSize;
+
+  PVOID const address = hadesmem::Alloc(process, page_size);
+  *static_cast<int*>(address) = 0x1337;
+  BOOST_TEST_EQ(hadesmem::Read<int>(process, address), 0x1337);
+  MEMORY_BASIC_INFORMATION mbi{};
+  BOOST_TEST(cache.Lookup(address, mbi));
+  BOOST_TEST_EQ(mbi.BaseAddress, address);
+  BOOST_TEST(cache.Lookup(static_cast<char*>(address) + page_size - 1, mbi));
+  BOOST_TEST_EQ(hadesmem::Read<int>(process_copy, address), 0x1337);
+
+  // A stale entry (the region was made inaccessible behind our back) is
+  // dropped and the read retried.
+  DWORD old_protect = 0;
+  BOOST_TEST(::VirtualProtect(address, page_size, PAGE_NOACCESS, &old_protect));
+  BOOST_TEST_EQ(hadesmem::Read<int>(process, address), 0x1337);
+  BOOST_TEST(cache.Lookup(address, mbi));
+  BOOST_TEST_EQ(mbi.Protect, static_cast<DWORD>(PAGE_NOACCESS));
+
+  hadesmem::Protect(process, address, PAGE_READWRITE);
+  BOOST_TEST(!cache.Lookup(address, mbi));
+  BOOST_TEST_EQ(hadesmem::Read<int>(process, address), 0x1337);
+  BOOST_TEST(cache.Lookup(address, mbi));
+  BOOST_TEST_EQ(mbi.Protect, static_cast<DWORD>(PAGE_READWRITE));
+
+  std::uint32_t const epoch = cache.GetEpoch();
+  hadesmem::Free(process, address);
+  BOOST_TEST_NE(cache.GetEpoch(), epoch);
+  BOOST_TEST_EQ(cache.GetSize(), 0UL);
+
+  cache.Insert(mbi);
+  cache.InvalidateRange(static_cast<char*>(address) + 1, 1);
+  BOOST_TEST_EQ(cache.GetSize(), 0UL);
+
+  // Protection is only ever changed over the current extent of a region, so
+  // a stale entry can't leave the rest of it inaccessible.
+  auto const address_na = static_cast<char*>(VirtualAlloc(
+    nullptr, page_size * 3, MEM_RESERVE | MEM_COMMIT, PAGE_NOACCESS));
+  BOOST_TEST(address_na != nullptr);
+  BOOST_TEST_EQ(hadesmem::Read<int>(process, address_na), 0);
+  BOOST_TEST(cache.Lookup(address_na + page_size, mbi));
+  BOOST_TEST(::VirtualProtect(
+    address_na + page_size, page_size * 2, PAGE_READONLY, &old_protect));
+  BOOST_TEST_EQ(hadesmem::Read<int>(process, address_na), 0);
+  BOOST_TEST(::VirtualQuery(address_na + page_size, &mbi, sizeof(mbi)));
+  BOOST_TEST_EQ(mbi.Protect, static_cast<DWORD>(PAGE_READONLY));
+  BOOST_TEST(::VirtualFree(address_na, 0, MEM_RELEASE));
+
+  process.DisableRegionCache();
+  BOOST_TEST(!process.IsRegionCacheEnabled());
+  BOOST_TEST(process_copy.IsRegionCacheEnabled());
+}
+
 int main()
 {
   TestReadPod();
   TestReadString();
   TestReadVector();
   TestReadCrossRegion();
+  TestReadRegionCache();
   return boost::report_errors();
 }
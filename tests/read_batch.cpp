@@ -0,0 +1,160 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#include <hadesmem/read_batch.hpp>
+#include <hadesmem/read_batch.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/read_batch_plan.hpp>
+#include <hadesmem/detail/winapi.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/process.hpp>
+
+void TestReadBatchPlan()
+{
+  std::vector<hadesmem::detail::ReadBatchRange> const ranges = {
+    {0x1010, 4}, {0x1000, 8}, {0x1004, 8}, {0x2000, 0}, {0x1100, 4},
+    {0x1200, 4}, {0x9000, 16}};
+
+  auto const plan = hadesmem::detail::PlanReadBatch(ranges, 0x100, 0);
+  BOOST_TEST_EQ(plan.order.size(), 6UL);
+  BOOST_TEST_EQ(plan.spans.size(), 2UL);
+  BOOST_TEST_EQ(plan.spans[0].address, 0x1000UL);
+  BOOST_TEST_EQ(plan.spans[0].size, 0x204UL);
+  BOOST_TEST_EQ(plan.spans[0].first, 0UL);
+  BOOST_TEST_EQ(plan.spans[0].count, 5UL);
+  BOOST_TEST_EQ(plan.order[0], 1UL);
+  BOOST_TEST_EQ(plan.order[1], 2UL);
+  BOOST_TEST_EQ(plan.order[2], 0UL);
+  BOOST_TEST_EQ(plan.spans[1].address, 0x9000UL);
+  BOOST_TEST_EQ(plan.spans[1].size, 16UL);
+
+  auto const plan_no_gap = hadesmem::detail::PlanReadBatch(ranges, 0, 0);
+  BOOST_TEST_EQ(plan_no_gap.spans.size(), 5UL);
+  BOOST_TEST_EQ(plan_no_gap.spans[0].size, 0xCUL);
+  BOOST_TEST_EQ(plan_no_gap.spans[0].count, 2UL);
+  BOOST_TEST_EQ(plan_no_gap.spans[1].address, 0x1010UL);
+
+  auto const plan_small = hadesmem::detail::PlanReadBatch(ranges, 0x100, 0x20);
+  BOOST_TEST_EQ(plan_small.spans.size(), 4UL);
+  BOOST_TEST_EQ(plan_small.spans[0].size, 0x14UL);
+  BOOST_TEST_EQ(plan_small.spans[0].count, 3UL);
+}
+
+void TestReadBatch()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+
+  std::array<std::uint32_t, 64> values;
+  for (std::size_t i = 0; i < values.size(); ++i)
+  {
+    values[i] = static_cast<std::uint32_t>(i * 3);
+  }
+
+  hadesmem::ReadBatch batch(process);
+  std::array<std::uint32_t, 64> results = {};
+  for (std::size_t i = 0; i < values.size(); i += 2)
+  {
+    BOOST_TEST_EQ(batch.Add(&values[i], &results[i]), i / 2);
+  }
+  std::uint32_t last = 0;
+  batch.Add(&values[values.size() - 1], &last);
+  batch.Add(&values[0], nullptr, 0);
+
+  BOOST_TEST_EQ(batch.Execute(), batch.GetNumRequests());
+  BOOST_TEST_EQ(batch.GetNumReads(), 1UL);
+  for (std::size_t i = 0; i < values.size(); i += 2)
+  {
+    BOOST_TEST_EQ(results[i], values[i]);
+    BOOST_TEST_EQ(results[i + 1], 0U);
+  }
+  BOOST_TEST_EQ(last, values[values.size() - 1]);
+
+  batch.Clear();
+  BOOST_TEST_EQ(batch.GetNumRequests(), 0UL);
+}
+
+void TestReadBatchPartialFailure()
+{
+  SYSTEM_INFO const sys_info = hadesmem::detail::GetSystemInfo();
+  DWORD const page_size = sys_info.dwPageSize;
+
+  auto const address = static_cast<std::uint8_t*>(VirtualAlloc(
+    nullptr, page_size * 3, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  BOOST_TEST(address != 0);
+  *reinterpret_cast<std::uint32_t*>(address + page_size - 4) = 0x1337;
+  *reinterpret_cast<std::uint32_t*>(address + page_size * 2) = 0x7331;
+  // Decommit the middle page so the merged span can't be read in one go.
+#pragma warning(suppress : 6250)
+  BOOST_TEST(VirtualFree(address + page_size, page_size, MEM_DECOMMIT) != 0);
+
+  hadesmem::Process const process(::GetCurrentProcessId());
+  hadesmem::ReadBatch batch(process, page_size * 2);
+  std::uint32_t first = 0;
+  std::uint32_t second = 0;
+  std::uint32_t third = 0;
+  batch.Add(address + page_size - 4, &first);
+  batch.Add(address + page_size + 4, &second);
+  batch.Add(address + page_size * 2, &third);
+
+  BOOST_TEST_EQ(batch.Execute(), 2UL);
+  BOOST_TEST(batch.Succeeded(0));
+  BOOST_TEST(!batch.Succeeded(1));
+  BOOST_TEST(batch.Succeeded(2));
+  BOOST_TEST_EQ(first, 0x1337U);
+  BOOST_TEST_EQ(third, 0x7331U);
+  BOOST_TEST_EQ(batch.GetNumReads(), 4UL);
+}
+
+void TestReadBatchNoAccessGap()
+{
+  SYSTEM_INFO const sys_info = hadesmem::detail::GetSystemInfo();
+  DWORD const page_size = sys_info.dwPageSize;
+
+  auto const address = static_cast<std::uint8_t*>(VirtualAlloc(
+    nullptr, page_size * 3, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  BOOST_TEST(address != 0);
+  *reinterpret_cast<std::uint32_t*>(address + page_size - 4) = 0x1337;
+  *reinterpret_cast<std::uint32_t*>(address + page_size * 2) = 0x7331;
+  DWORD old_protect = 0;
+  BOOST_TEST(VirtualProtect(address + page_size,
+                            page_size,
+                            PAGE_NOACCESS,
+                            &old_protect) != 0);
+
+  hadesmem::Process const process(::GetCurrentProcessId());
+  hadesmem::ReadBatch batch(process, page_size * 2);
+  std::uint32_t first = 0;
+  std::uint32_t third = 0;
+  batch.Add(address + page_size - 4, &first);
+  batch.Add(address + page_size * 2, &third);
+
+  BOOST_TEST_EQ(batch.Execute(), 2UL);
+  BOOST_TEST_EQ(first, 0x1337U);
+  BOOST_TEST_EQ(third, 0x7331U);
+  BOOST_TEST_EQ(batch.GetNumReads(), 3UL);
+
+  // The gap between the requests must be left alone.
+  MEMORY_BASIC_INFORMATION mbi = {};
+  BOOST_TEST(VirtualQuery(address + page_size, &mbi, sizeof(mbi)) != 0);
+  BOOST_TEST_EQ(mbi.Protect, static_cast<DWORD>(PAGE_NOACCESS));
+
+  BOOST_TEST(VirtualFree(address, 0, MEM_RELEASE) != 0);
+}
+
+int main()
+{
+  TestReadBatchPlan();
+  TestReadBatch();
+  TestReadBatchPartialFailure();
+  TestReadBatchNoAccessGap();
+  return boost::report_errors();
+}
@@ -0,0 +1,112 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#include <hadesmem/read.hpp>
+#include <hadesmem/read.hpp>
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/process.hpp>
+
+// Counts allocations so we can check that reading a string into a reserved
+// output with a reused scratch buffer doesn't allocate.
+
+namespace
+{
+std::size_t g_num_allocs = 0;
+}
+
+void* operator new(std::size_t size)
+{
+  ++g_num_allocs;
+  if (void* const p = std::malloc(size ? size : 1))
+  {
+    return p;
+  }
+
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) HADESMEM_DETAIL_NOEXCEPT
+{
+  std::free(p);
+}
+
+template <typename T>
+std::size_t CountAllocs(hadesmem::Process const& process,
+                        T* str,
+                        std::size_t num_calls,
+                        std::basic_string<T>& out,
+                        std::vector<T>& buf)
+{
+  std::size_t const num_allocs = g_num_allocs;
+  for (std::size_t i = 0; i < num_calls; ++i)
+  {
+    out.clear();
+    hadesmem::ReadStringEx<T>(process,
+                              str,
+                              std::back_inserter(out),
+                              hadesmem::detail::ReadStringTraits<T>::kChunkLen,
+                              nullptr,
+                              buf);
+  }
+  return g_num_allocs - num_allocs;
+}
+
+void TestReadStringNoAlloc()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+
+  std::string short_str = "GetProcAddress";
+  std::string long_str(0x3000, 'x');
+  std::wstring short_wstr = L"kernel32.dll";
+  std::wstring long_wstr(0x3000, L'x');
+
+  std::string out;
+  out.reserve(0x4000);
+  std::wstring wout;
+  wout.reserve(0x4000);
+  std::vector<char> buf;
+  std::vector<wchar_t> wbuf;
+
+  // Short strings never touch the scratch buffer.
+  BOOST_TEST_EQ(CountAllocs(process, &short_str[0], 1000, out, buf), 0UL);
+  BOOST_TEST_EQ(out, short_str);
+  BOOST_TEST(buf.empty());
+  BOOST_TEST_EQ(CountAllocs(process, &short_wstr[0], 1000, wout, wbuf), 0UL);
+  BOOST_TEST(wout == short_wstr);
+
+  // Long strings allocate the scratch buffer once.
+  BOOST_TEST_EQ(CountAllocs(process, &long_str[0], 1, out, buf), 1UL);
+  BOOST_TEST_EQ(CountAllocs(process, &long_str[0], 1000, out, buf), 0UL);
+  BOOST_TEST_EQ(out, long_str);
+  BOOST_TEST_EQ(CountAllocs(process, &long_wstr[0], 1, wout, wbuf), 1UL);
+  BOOST_TEST_EQ(CountAllocs(process, &long_wstr[0], 1000, wout, wbuf), 0UL);
+  BOOST_TEST(wout == long_wstr);
+
+  // Short strings don't allocate through the plain overload either.
+  std::size_t const num_allocs = g_num_allocs;
+  for (std::size_t i = 0; i < 1000; ++i)
+  {
+    out.clear();
+    hadesmem::ReadString<char>(process, &short_str[0], std::back_inserter(out));
+  }
+  BOOST_TEST_EQ(g_num_allocs - num_allocs, 0UL);
+  BOOST_TEST_EQ(out, short_str);
+}
+
+int main()
+{
+  TestReadStringNoAlloc();
+  return boost::report_errors();
+}
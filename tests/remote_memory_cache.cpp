@@ -0,0 +1,165 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#include <hadesmem/remote_memory_cache.hpp>
+#include <hadesmem/remote_memory_cache.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/alloc.hpp>
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/winapi.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/read.hpp>
+#include <hadesmem/write.hpp>
+
+void TestRemoteMemoryCache()
+{
+  SYSTEM_INFO const sys_info = hadesmem::detail::GetSystemInfo();
+  DWORD const page_size = sys_info.dwPageSize;
+
+  hadesmem::Process process(::GetCurrentProcessId());
+  auto const cache = std::make_shared<hadesmem::RemoteMemoryCache>(page_size);
+  process.SetMemoryCache(cache);
+  BOOST_TEST_EQ(process.GetMemoryCache(), cache.get());
+
+  auto const address = static_cast<std::uint8_t*>(VirtualAlloc(
+    nullptr, page_size * 3, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  BOOST_TEST(address != 0);
+
+  auto const value = reinterpret_cast<int*>(address + 0x10);
+  *value = 0x1337;
+  BOOST_TEST_EQ(hadesmem::Read<int>(process, value), 0x1337);
+  BOOST_TEST_EQ(cache->GetNumMisses(), 1ULL);
+  BOOST_TEST_EQ(cache->GetNumPages(), 1UL);
+
+  // Reads are served from the snapshot until it is invalidated.
+  *value = 0x7331;
+  BOOST_TEST_EQ(hadesmem::Read<int>(process, value), 0x1337);
+  BOOST_TEST_EQ(hadesmem::ReadVector<int>(process, value, 1)[0], 0x1337);
+  BOOST_TEST_EQ(cache->GetNumMisses(), 1ULL);
+  BOOST_TEST_EQ(cache->GetNumHits(), 2ULL);
+  cache->Invalidate();
+  BOOST_TEST_EQ(hadesmem::Read<int>(process, value), 0x7331);
+
+  // Writes through hadesmem drop the pages they touch.
+  hadesmem::Write(process, value, 0x1234);
+  BOOST_TEST_EQ(hadesmem::Read<int>(process, value), 0x1234);
+
+  // Strings which cross a page boundary.
+  std::string const test_string = "Hello, cached world!";
+  char* const str = reinterpret_cast<char*>(address + page_size - 5);
+  std::memcpy(str, test_string.c_str(), test_string.size() + 1);
+  cache->Invalidate();
+  BOOST_TEST_EQ(hadesmem::ReadString<char>(process, str), test_string);
+  BOOST_TEST_EQ(
+    hadesmem::ReadStringBounded<char>(process, str, str + 5),
+    test_string.substr(0, 5));
+  std::wstring const test_wstring = L"Wide";
+  wchar_t* const wstr =
+    reinterpret_cast<wchar_t*>(address + page_size * 2 - 3);
+  std::memcpy(wstr,
+              test_wstring.c_str(),
+              (test_wstring.size() + 1) * sizeof(wchar_t));
+  BOOST_TEST(hadesmem::ReadString<wchar_t>(process, wstr) == test_wstring);
+
+  // Pages which are not readable are fetched via the guarded path.
+  DWORD old_protect = 0;
+  BOOST_TEST(VirtualProtect(address + page_size * 2,
+                            page_size,
+                            PAGE_NOACCESS,
+                            &old_protect) != 0);
+  cache->Invalidate();
+  BOOST_TEST(hadesmem::ReadString<wchar_t>(process, wstr) == test_wstring);
+
+  // Pages which can't be read at all fail as usual.
+#pragma warning(suppress : 6250)
+  BOOST_TEST(VirtualFree(address + page_size * 2, page_size, MEM_DECOMMIT) !=
+             0);
+  cache->Invalidate();
+  BOOST_TEST_THROWS(hadesmem::Read<int>(process, address + page_size * 2),
+                    hadesmem::Error);
+  BOOST_TEST_THROWS(hadesmem::Read<int>(process, address + page_size * 2),
+                    hadesmem::Error);
+  std::vector<char> const zeroes = hadesmem::ReadVectorEx<char>(
+    process,
+    address + page_size * 2,
+    16,
+    hadesmem::ReadFlags::kZeroFillReserved);
+  BOOST_TEST(zeroes == std::vector<char>(16));
+
+  process.SetMemoryCache(nullptr);
+  BOOST_TEST(process.GetMemoryCache() == nullptr);
+}
+
+void TestRemoteMemoryCacheRuns()
+{
+  SYSTEM_INFO const sys_info = hadesmem::detail::GetSystemInfo();
+  DWORD const page_size = sys_info.dwPageSize;
+
+  hadesmem::Process process(::GetCurrentProcessId());
+  auto const cache = std::make_shared<hadesmem::RemoteMemoryCache>(
+    page_size, std::chrono::milliseconds(0), page_size * 4);
+  process.SetMemoryCache(cache);
+
+  auto const address = static_cast<std::uint8_t*>(VirtualAlloc(
+    nullptr, page_size * 8, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  BOOST_TEST(address != 0);
+  for (std::size_t i = 0; i < page_size * 8; ++i)
+  {
+    address[i] = static_cast<std::uint8_t>(i);
+  }
+
+  // A run of missing pages is fetched and cached as a whole, around pages
+  // which are already cached.
+  BOOST_TEST_EQ(hadesmem::Read<std::uint8_t>(process, address + page_size),
+                address[page_size]);
+  std::vector<std::uint8_t> const expected(address, address + page_size * 4);
+  BOOST_TEST(hadesmem::ReadVector<std::uint8_t>(
+               process, address, page_size * 4) == expected);
+  BOOST_TEST_EQ(cache->GetNumPages(), 4UL);
+  BOOST_TEST_EQ(cache->GetNumMisses(), 4ULL);
+  BOOST_TEST_EQ(cache->GetNumHits(), 1ULL);
+
+  // Reads larger than the maximum bypass the cache.
+  std::vector<std::uint8_t> const expected_all(address,
+                                                address + page_size * 8);
+  BOOST_TEST(hadesmem::ReadVector<std::uint8_t>(
+               process, address, page_size * 8) == expected_all);
+  BOOST_TEST_EQ(cache->GetNumPages(), 4UL);
+  BOOST_TEST_EQ(cache->GetNumMisses(), 4ULL);
+
+  // Runs which can't be read as a whole are retried a page at a time.
+#pragma warning(suppress : 6250)
+  BOOST_TEST(VirtualFree(address + page_size * 6, page_size, MEM_DECOMMIT) !=
+             0);
+  BOOST_TEST_THROWS(
+    hadesmem::ReadVector<std::uint8_t>(process, address + page_size * 4,
+                                       page_size * 3),
+    hadesmem::Error);
+  BOOST_TEST_EQ(cache->GetNumPages(), 7UL);
+  BOOST_TEST(hadesmem::ReadVector<std::uint8_t>(
+               process, address + page_size * 4, page_size * 2) ==
+             std::vector<std::uint8_t>(address + page_size * 4,
+                                       address + page_size * 6));
+
+  BOOST_TEST(VirtualFree(address, 0, MEM_RELEASE) != 0);
+  process.SetMemoryCache(nullptr);
+}
+
+int main()
+{
+  TestRemoteMemoryCache();
+  TestRemoteMemoryCacheRuns();
+  return boost::report_errors();
+}
@@ -0,0 +1,96 @@
+// Copyright (C) 2010-2014 Joshua Boyce.
+// See the file COPYING for copying permission.
+
+#include <hadesmem/write_transaction.hpp>
+#include <hadesmem/write_transaction.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/winapi.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/protect.hpp>
+#include <hadesmem/read.hpp>
+
+void TestWriteTransaction()
+{
+  SYSTEM_INFO const sys_info = hadesmem::detail::GetSystemInfo();
+  DWORD const page_size = sys_info.dwPageSize;
+
+  auto const address = static_cast<std::uint8_t*>(VirtualAlloc(
+    nullptr, page_size * 2, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  BOOST_TEST(address != 0);
+  DWORD old_protect = 0;
+#pragma warning(suppress : 6387)
+  BOOST_TEST(VirtualProtect(
+               address, page_size * 2, PAGE_READONLY, &old_protect) != 0);
+
+  hadesmem::Process const process(::GetCurrentProcessId());
+  hadesmem::WriteTransaction transaction(process);
+  transaction.Add(address, 0x11111111U);
+  std::uint8_t const overlap[] = {0xAA, 0xBB};
+  transaction.Add(address + 2, overlap, sizeof(overlap));
+  transaction.Add(address + 0x100, 0x22222222U);
+  transaction.Add(address + page_size - 2, 0x33333333U);
+  transaction.Add(address + 0x200, nullptr, 0);
+  BOOST_TEST_EQ(transaction.GetNumRequests(), 5UL);
+
+  transaction.Commit();
+  BOOST_TEST_EQ(transaction.GetNumRegions(), 1UL);
+  BOOST_TEST_EQ(transaction.GetNumWrites(), 3UL);
+
+  std::vector<std::uint8_t> const expected_start = {0x11, 0x11, 0xAA, 0xBB, 0};
+  BOOST_TEST(hadesmem::ReadVector<std::uint8_t>(process, address, 5) ==
+             expected_start);
+  BOOST_TEST_EQ(hadesmem::Read<std::uint32_t>(process, address + 0x100),
+                0x22222222U);
+  BOOST_TEST_EQ(
+    hadesmem::Read<std::uint32_t>(process, address + page_size - 2),
+    0x33333333U);
+  BOOST_TEST_EQ(hadesmem::Read<std::uint32_t>(process, address + 0x200), 0U);
+  BOOST_TEST(!hadesmem::CanWrite(process, address));
+
+  BOOST_TEST(VirtualFree(address, 0, MEM_RELEASE) != 0);
+}
+
+void TestWriteTransactionRollback()
+{
+  SYSTEM_INFO const sys_info = hadesmem::detail::GetSystemInfo();
+  DWORD const page_size = sys_info.dwPageSize;
+
+  auto const address = static_cast<std::uint8_t*>(VirtualAlloc(
+    nullptr, page_size * 2, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  BOOST_TEST(address != 0);
+  address[0] = 0x12;
+  DWORD old_protect = 0;
+#pragma warning(suppress : 6387)
+  BOOST_TEST(VirtualProtect(address + page_size,
+                            page_size,
+                            PAGE_READWRITE | PAGE_GUARD,
+                            &old_protect) != 0);
+
+  hadesmem::Process const process(::GetCurrentProcessId());
+  hadesmem::WriteTransaction transaction(process);
+  transaction.Add(address, static_cast<std::uint8_t>(0x34));
+  transaction.Add(address + page_size, static_cast<std::uint8_t>(0x56));
+
+  BOOST_TEST_THROWS(transaction.Commit(), hadesmem::Error);
+  BOOST_TEST_EQ(transaction.GetNumRegions(), 2UL);
+  BOOST_TEST_EQ(transaction.GetNumWrites(), 1UL);
+  BOOST_TEST_EQ(address[0], 0x12);
+
+  BOOST_TEST(VirtualFree(address, 0, MEM_RELEASE) != 0);
+}
+
+int main()
+{
+  TestWriteTransaction();
+  TestWriteTransactionRollback();
+  return boost::report_errors();
+}